@@ -0,0 +1,65 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+/* Aggregate of one channel's samples over one or more DMA frames */
+struct FrameStats {
+    uint32_t sum{0};
+    uint16_t count{0};
+    uint16_t min{UINT16_MAX};
+    uint16_t max{0};
+
+    constexpr uint16_t average() const noexcept { return count ? static_cast<uint16_t>((sum + count / 2) / count) : 0; }
+    constexpr uint16_t spread() const noexcept { return count ? max - min : 0; }
+};
+
+/**
+ * Parser for ESP32 continuous ADC frames in ADC_DIGI_OUTPUT_FORMAT_TYPE1:
+ * one little endian 16 bit word per sample, bits 0-11 data, bits 12-15
+ * channel. Free of driver includes so it can be fed synthetic frames.
+ */
+namespace adc_frame
+{
+    inline constexpr size_t kType1SampleBytes = 2;
+    inline constexpr uint16_t kType1DataMask = 0x0FFF;
+    inline constexpr uint8_t kType1ChannelShift = 12;
+
+    /* Call fn(data) for every sample of channel in frame, a trailing odd byte is ignored */
+    template<typename Fn>
+    constexpr void forEachType1(const uint8_t* frame, size_t len, uint8_t channel, Fn&& fn)
+    {
+        for(size_t i = 0; i + kType1SampleBytes <= len; i += kType1SampleBytes) {
+            const uint16_t word = static_cast<uint16_t>(frame[i] | (frame[i + 1] << 8));
+            if((word >> kType1ChannelShift) == channel) {
+                fn(static_cast<uint16_t>(word & kType1DataMask));
+            }
+        }
+    }
+
+    /* Add one sample to stats */
+    constexpr void accumulate(FrameStats& stats, uint16_t data)
+    {
+        if(stats.count == UINT16_MAX) {
+            return;
+        }
+        stats.sum += data;
+        stats.count++;
+        stats.min = std::min(stats.min, data);
+        stats.max = std::max(stats.max, data);
+    }
+
+    /* Add the samples of channel in frame to stats */
+    constexpr void accumulateType1(FrameStats& stats, const uint8_t* frame, size_t len, uint8_t channel)
+    {
+        forEachType1(frame, len, channel, [&stats](uint16_t data) { accumulate(stats, data); });
+    }
+
+    constexpr FrameStats parseType1(const uint8_t* frame, size_t len, uint8_t channel)
+    {
+        FrameStats stats{};
+        accumulateType1(stats, frame, len, channel);
+        return stats;
+    }
+} // namespace adc_frame
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+/* Payload of the calibrate topic, see parseCalibrationCommand */
+enum class CalibrationCommand : uint8_t {CaptureDry, CaptureWet, Reset};
+
+/* "dry", "wet" or "reset", surrounding whitespace ignored */
+std::optional<CalibrationCommand> parseCalibrationCommand(std::string_view payload);
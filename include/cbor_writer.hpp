@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * Minimal CBOR (RFC 8949) writer on a caller provided buffer.
+ * No allocation; once the buffer is exhausted all further writes are
+ * ignored and ok() returns false.
+ */
+class CborWriter {
+public:
+    CborWriter(uint8_t* buf, size_t cap) : _buf(buf), _cap(cap) {}
+
+    void writeUint(uint64_t value) { writeHead(MAJOR_UINT, value); }
+
+    void writeInt(int64_t value)
+    {
+        if(value >= 0) {
+            writeHead(MAJOR_UINT, static_cast<uint64_t>(value));
+        } else {
+            writeHead(MAJOR_NINT, static_cast<uint64_t>(-(value + 1)));
+        }
+    }
+
+    void writeText(std::string_view text)
+    {
+        writeHead(MAJOR_TEXT, text.size());
+        if(!reserve(text.size())) {
+            return;
+        }
+        std::copy(text.begin(), text.end(), _buf + _len);
+        _len += text.size();
+    }
+
+    void beginArray(size_t count) { writeHead(MAJOR_ARRAY, count); }
+    void beginMap(size_t pairs) { writeHead(MAJOR_MAP, pairs); }
+    /* Indefinite length array, has to be closed with endIndefinite() */
+    void beginIndefiniteArray() { writeByte(MAJOR_ARRAY | INDEFINITE); }
+    void endIndefinite() { writeByte(BREAK); }
+
+    bool ok() const noexcept { return !_overflow; }
+    size_t size() const noexcept { return _len; }
+    size_t remaining() const noexcept { return _cap - _len; }
+
+    /* Encoded size of an unsigned integer head */
+    static constexpr size_t headSize(uint64_t value) noexcept
+    {
+        return value < 24 ? 1 : value <= UINT8_MAX ? 2 : value <= UINT16_MAX ? 3 : value <= UINT32_MAX ? 5 : 9;
+    }
+
+    /* Encoded size of a signed integer */
+    static constexpr size_t intSize(int64_t value) noexcept
+    {
+        return headSize(value >= 0 ? static_cast<uint64_t>(value) : static_cast<uint64_t>(-(value + 1)));
+    }
+
+private:
+    bool reserve(size_t n)
+    {
+        if(_overflow || !_buf || n > _cap - _len) {
+            _overflow = true;
+            return false;
+        }
+        return true;
+    }
+
+    void writeByte(uint8_t byte)
+    {
+        if(reserve(1)) {
+            _buf[_len++] = byte;
+        }
+    }
+
+    void writeHead(uint8_t major, uint64_t value)
+    {
+        const size_t n = headSize(value);
+        if(!reserve(n)) {
+            return;
+        }
+
+        if(n == 1) {
+            _buf[_len++] = major | static_cast<uint8_t>(value);
+            return;
+        }
+
+        const uint8_t info = n == 2 ? 24 : n == 3 ? 25 : n == 5 ? 26 : 27;
+        _buf[_len++] = major | info;
+        // Big endian argument
+        for(size_t i = n - 1; i > 0; --i) {
+            _buf[_len++] = static_cast<uint8_t>(value >> (8 * (i - 1)));
+        }
+    }
+
+    static constexpr uint8_t MAJOR_UINT = 0 << 5;
+    static constexpr uint8_t MAJOR_NINT = 1 << 5;
+    static constexpr uint8_t MAJOR_TEXT = 3 << 5;
+    static constexpr uint8_t MAJOR_ARRAY = 4 << 5;
+    static constexpr uint8_t MAJOR_MAP = 5 << 5;
+    static constexpr uint8_t INDEFINITE = 31;
+    static constexpr uint8_t BREAK = 0xFF;
+
+    uint8_t* _buf;
+    size_t _cap;
+    size_t _len{0};
+    bool _overflow{false};
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "publish_message.hpp"
+#include "topic_registry.hpp"
+#include "freertos/FreeRTOS.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+/**
+ * Queued state message per topic for latest value wins coalescing.
+ * A newer value for a pending topic overwrites the queued slot in place.
+ * Producers and the manager task share it, access is guarded by a spinlock.
+ */
+class CoalesceTable {
+public:
+    /* Overwrite the pending message of topic, false if none is queued.
+       enqueuedMs restarts so queue latency is measured for the value that is sent */
+    bool replace(TopicId topic, std::string_view payload, int qos, uint32_t enqueuedMs)
+    {
+        bool replaced = false;
+
+        portENTER_CRITICAL(&_lock);
+        PublishSlot pending = _pending[index(topic)];
+        if(pending) {
+            std::copy(payload.begin(), payload.end(), pending->payload.begin());
+            if(payload.size() < pending->payload.size()) {
+                pending->payload[payload.size()] = '\0';
+            }
+            pending->payloadLen = static_cast<uint16_t>(payload.size());
+            pending->qos = qos;
+            pending->enqueuedMs = enqueuedMs;
+            replaced = true;
+        }
+        portEXIT_CRITICAL(&_lock);
+
+        return replaced;
+    }
+
+    /* Register a slot before it becomes visible in the queue */
+    void track(PublishSlot msg)
+    {
+        portENTER_CRITICAL(&_lock);
+        if(!_pending[index(msg->topic)]) {
+            _pending[index(msg->topic)] = msg;
+        }
+        portEXIT_CRITICAL(&_lock);
+    }
+
+    /* True while producers may still overwrite msg in place */
+    bool tracks(PublishSlot msg)
+    {
+        portENTER_CRITICAL(&_lock);
+        const bool tracked = _pending[index(msg->topic)] == msg;
+        portEXIT_CRITICAL(&_lock);
+        return tracked;
+    }
+
+    /* Claim a slot taken from the queue, no producer touches it afterwards */
+    void forget(PublishSlot msg)
+    {
+        portENTER_CRITICAL(&_lock);
+        if(_pending[index(msg->topic)] == msg) {
+            _pending[index(msg->topic)] = nullptr;
+        }
+        portEXIT_CRITICAL(&_lock);
+    }
+
+private:
+    static constexpr size_t index(TopicId topic) noexcept { return static_cast<size_t>(topic); }
+
+    portMUX_TYPE _lock = portMUX_INITIALIZER_UNLOCKED;
+    std::array<PublishSlot, kTopicCount> _pending{};
+};
@@ -1,5 +1,12 @@
 #pragma once
 
+#include "payload_encoder.hpp"
+#include "deadband_filter.hpp"
+#include "token_bucket.hpp"
+#include "sensor_filter.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <string_view>
 
 #ifndef WIFI_SSID
@@ -11,7 +18,82 @@
 
 namespace cfg
 {
+    enum class PublishMode : uint8_t {Blocking, Enqueue};
+    enum class ReadingTransport : uint8_t {Queue, Ring};
+    enum class AdcBackend : uint8_t {Oneshot, Continuous};
+
     inline constexpr std::string_view kWifiSsid{WIFI_SSID};
     inline constexpr std::string_view kWifiPass{WIFI_PASS};
     inline constexpr std::string_view kMqttBrokerUri{"mqtt://192.168.2.54:1883"};
+    // Device scoped topics are <root>/<device id>/<name>, see topic_registry.hpp
+    inline constexpr std::string_view kDeviceId{"soil-01"};
+    inline constexpr std::string_view kTopicRoot{"sensor"};
+    inline constexpr std::string_view kStateTopic{"state"};
+    inline constexpr std::string_view kDiagnosticsTopic{"diagnostics"};
+    inline constexpr std::string_view kCalibrateTopic{"calibrate"}; // inbound, see soil_calibration.hpp
+    inline constexpr uint32_t kMetricsIntervalMs{5 * 60 * 1000}; // pipeline metrics on the diagnostics topic
+    inline constexpr size_t kMqttPubQueueDepth{32}; // number of pooled publish messages
+    inline constexpr size_t kPriorityQueueDepth{8}; // separate pool for control/alarm messages
+    inline constexpr uint8_t kHighPriorityBurst{4}; // high messages before one bulk message
+    // Enqueue hands messages to the client outbox without blocking the manager task
+    inline constexpr PublishMode kMqttPublishMode{PublishMode::Enqueue};
+    inline constexpr size_t kMqttOutboxBudget{8 * 1024}; // outbox bytes before backpressure
+    inline constexpr size_t kMqttOutboxHighReserve{2 * 1024}; // extra outbox bytes for the high lane
+    // MQTT 5 (needs CONFIG_MQTT_PROTOCOL_5). With PublishMode::Blocking registered topics are
+    // sent as topic aliases. Enqueue keeps full topics, an enqueued message may leave on a
+    // later connection that does not know the alias
+    inline constexpr bool kMqttProtocol5{true};
+    inline constexpr uint16_t kMqttTopicAliasMax{10}; // upper bound, lowered to the broker's Topic Alias Maximum
+    // Persistent session: stable client id (from the MAC), no clean session, the client keeps
+    // running across wifi flaps and reconnects right away instead of a full stop/start
+    inline constexpr bool kMqttPersistentSession{true};
+    inline constexpr uint32_t kMqttSessionExpiryS{24 * 60 * 60}; // MQTT 5 only, broker keeps the session this long
+    // QoS>0 messages awaiting PUBACK
+    inline constexpr size_t kInflightWindow{8};
+    inline constexpr uint32_t kInflightAckTimeoutMs{10000};
+    inline constexpr uint8_t kInflightMaxAttempts{3};
+
+    // Readings are batched into one publish per window
+    inline constexpr std::string_view kBatchTopic{"sensor/soil/batch"};
+    inline constexpr uint32_t kBatchWindowMs{60000};
+    inline constexpr size_t kBatchMaxReadings{16};
+    // Ring is lock free but needs a single producer task for queueReading
+    inline constexpr ReadingTransport kReadingTransport{ReadingTransport::Queue};
+    inline constexpr PayloadFormat kPayloadFormat{PayloadFormat::Cbor}; // Text for debugging
+
+    // Report on change per reading channel, heartbeat after max silence
+    inline constexpr std::array<DeadbandConfig, kChannelCount> kDeadband{{
+        {2, 0, 15 * 60 * 1000},     // SoilMoisture: 2 %
+        {40, 20, 15 * 60 * 1000},   // SoilRaw: the larger of 40 counts and 2 %
+    }};
+
+    // Store and forward on flash while the broker is unreachable
+    inline constexpr std::string_view kFlashLogPartition{"storelog"};
+    inline constexpr size_t kFlashSpillThreshold{8};    // queued offline messages before spilling
+
+    // Drain pacing in messages per second and burst, live RAM queue goes before the flash backlog
+    inline constexpr TokenBucketConfig kLiveRate{20, 10};
+    inline constexpr TokenBucketConfig kBacklogRate{5, 5};
+
+    // Soil sensor ADC, Continuous runs the DMA for one whole frame per read and stops it again
+    inline constexpr AdcBackend kAdcBackend{AdcBackend::Continuous};
+    inline constexpr uint32_t kAdcSampleRateHz{20000};  // lowest rate the ESP32 digital controller supports
+    inline constexpr size_t kAdcFrameBytes{256};        // TYPE1: 2 bytes per sample
+    inline constexpr uint32_t kAdcFrameTimeoutMs{100};
+    inline constexpr size_t kAdcOversample{16};         // samples averaged per filter output
+    // Both backends feed the filter the same number of samples per acquisition: one DMA frame
+    // or a oneshot burst of the same length, 8 filter outputs per read
+    inline constexpr size_t kAdcSamplesPerRead{kAdcFrameBytes / 2};
+    static_assert(kAdcSamplesPerRead % kAdcOversample == 0, "A read has to end on a filter output");
+    // Soil sensor filter stages: decimation, spike rejection, smoothing. The median window
+    // (5 outputs) and the EMA (alpha 1/4) mostly run within one read, so a real step shows
+    // ~80 % after the next read and >98 % after the one after that (10-20 s), while a spike
+    // shorter than 2 outputs (32 samples) never gets through
+    using SoilFilter = filter::FilterChain<
+        filter::Oversample<kAdcOversample>,
+        filter::MedianOf<5>,
+        filter::Ema<2>>;
+    // Soil sensor dry/wet points, kept in NVS and captured on request
+    inline constexpr std::string_view kCalibrationNamespace{"soil"};
+    inline constexpr size_t kCalibrationSamples{32};    // acquisitions averaged per captured point
 } // namespace cfg
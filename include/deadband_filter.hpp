@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+
+struct DeadbandConfig {
+    int32_t absolute;           // minimum change in value units, 0 = off
+    uint16_t relativePermille;  // minimum change relative to last published value, 0 = off
+    uint32_t maxSilenceMs;      // publish anyway after this long, 0 = never
+};
+
+/**
+ * Report on change filter: a sample passes only if it moved far enough
+ * from the last published value or the last publish is too old. With both
+ * thresholds set the larger one applies, so a change has to pass both.
+ * With both thresholds off every sample passes.
+ */
+class DeadbandFilter {
+public:
+    DeadbandFilter() = default;
+    explicit DeadbandFilter(const DeadbandConfig& config) : _config(config) {}
+
+    /* True if value should be published, it then becomes the new reference */
+    bool accept(int32_t value, uint32_t nowMs)
+    {
+        if(!_hasLast || changed(value) || silenceExceeded(nowMs)) {
+            _hasLast = true;
+            _last = value;
+            _lastMs = nowMs;
+            return true;
+        }
+        return false;
+    }
+
+    void reset() noexcept { _hasLast = false; }
+
+private:
+    bool changed(int32_t value) const
+    {
+        const int64_t delta = std::llabs(static_cast<int64_t>(value) - _last);
+        const int64_t relative = std::llabs(static_cast<int64_t>(_last)) * _config.relativePermille / 1000;
+        const int64_t threshold = _config.absolute > relative ? _config.absolute : relative;
+        return threshold == 0 || delta >= threshold;
+    }
+
+    bool silenceExceeded(uint32_t nowMs) const
+    {
+        return _config.maxSilenceMs != 0 && nowMs - _lastMs >= _config.maxSilenceMs;
+    }
+
+    DeadbandConfig _config{};
+    bool _hasLast{false};
+    int32_t _last{0};
+    uint32_t _lastMs{0};
+};
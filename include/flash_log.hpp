@@ -0,0 +1,92 @@
+#pragma once
+
+#include "esp_partition.h"
+#include "esp_err.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Log structured ring buffer on a raw flash partition.
+ *
+ * Sectors are written strictly in ring order and each one is erased only
+ * when the writer wraps onto it, which spreads wear evenly. Every sector
+ * starts with a sequence number so the ring position is recovered after a
+ * reboot. Records are consumed by clearing a marker word instead of erasing,
+ * torn records from a power loss fail their crc and are skipped.
+ * Reading copies one record at a time into a caller buffer.
+ */
+class FlashLog {
+public:
+    explicit FlashLog(const char* partitionLabel);
+
+    FlashLog(const FlashLog&) = delete;
+    FlashLog& operator=(const FlashLog&) = delete;
+
+    /* Append a record, overwrites the oldest sector when the ring is full */
+    esp_err_t append(const void* data, size_t len);
+    /* Copy the oldest pending record into out without consuming it */
+    esp_err_t peek(void* out, size_t cap, size_t& len);
+    /* Consume the record returned by the last peek */
+    esp_err_t pop();
+
+    bool empty() const noexcept { return _pending == 0; }
+    size_t pending() const noexcept { return _pending; }
+    /* Records lost because the ring wrapped onto unread data */
+    uint32_t dropped() const noexcept { return _dropped; }
+    bool isValid() const noexcept { return _mounted; }
+
+    static constexpr size_t MAX_RECORD_LEN = 512;
+
+private:
+    struct SectorHeader {
+        uint32_t magic;
+        uint32_t seq;
+    };
+
+    struct RecordHeader {
+        uint16_t len;
+        uint16_t marker;
+        uint32_t crc;
+        uint32_t consumed;  // erased = pending, cleared on pop
+    };
+
+    enum class RecordState : uint8_t {Free, Valid, Consumed, Corrupt};
+
+    /* Rebuild read/write position from flash contents */
+    bool mount();
+    /* Erase a sector and make it the write sector */
+    esp_err_t openSector(size_t sector);
+    /* Move writer to the next sector, dropping the oldest one if needed */
+    esp_err_t advanceWriteSector();
+    /* Move reader to the next pending record */
+    bool seekReadable();
+    bool sectorValid(size_t sector, SectorHeader& header) const;
+    RecordState readHeader(size_t sector, size_t offset, RecordHeader& header) const;
+    bool crcMatches(size_t sector, size_t offset, const RecordHeader& header) const;
+    /* Count intact pending records from offset to the end of a sector, returns end offset */
+    size_t scanSector(size_t sector, size_t offset, size_t& pending) const;
+
+    size_t nextSector(size_t sector) const noexcept { return (sector + 1) % _sectorCount; }
+    static size_t address(size_t sector, size_t offset) noexcept { return sector * SECTOR_SIZE + offset; }
+    static constexpr size_t recordSize(size_t len) noexcept { return sizeof(RecordHeader) + ((len + 3) & ~size_t{3}); }
+
+    const esp_partition_t* _partition{};
+    size_t _sectorCount{0};
+    size_t _writeSector{0};
+    size_t _writeOffset{0};
+    size_t _readSector{0};
+    size_t _readOffset{0};
+    uint32_t _seq{0};
+    size_t _pending{0};
+    uint32_t _dropped{0};
+    bool _peeked{false};
+    bool _mounted{false};
+
+    static constexpr size_t SECTOR_SIZE = 4096;
+    static constexpr size_t FIRST_RECORD = sizeof(SectorHeader);
+    static constexpr uint32_t SECTOR_MAGIC = 0x474F4C46; // "FLOG"
+    static constexpr uint16_t RECORD_MARKER = 0x5AA5;
+    static constexpr uint16_t ERASED16 = 0xFFFF;
+    static constexpr uint32_t ERASED32 = 0xFFFFFFFF;
+    static constexpr size_t CRC_CHUNK = 64;
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Bounded table of QoS>0 messages waiting for their PUBACK, keyed by
+ * msg_id. Owns nothing, the caller releases the returned items.
+ * Only used from the manager task.
+ */
+template<typename T, size_t N>
+class InflightWindow {
+public:
+    struct Entry {
+        T* item;
+        int msgId;
+        uint32_t firstSentMs;   // for ack latency
+        uint32_t lastSentMs;    // start of the current ack timeout
+        uint8_t attempts;
+    };
+
+    bool full() const noexcept { return _count >= N; }
+    bool empty() const noexcept { return _count == 0; }
+    size_t size() const noexcept { return _count; }
+    static constexpr size_t capacity() noexcept { return N; }
+
+    bool track(T* item, int msgId, uint32_t nowMs)
+    {
+        for(auto& entry : _entries) {
+            if(!entry.item) {
+                entry = Entry{item, msgId, nowMs, nowMs, 1};
+                _count++;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /* Remove the entry acknowledged by msgId, nullptr if unknown */
+    T* ack(int msgId, uint32_t& firstSentMs)
+    {
+        Entry* entry = find(msgId);
+        if(!entry) {
+            return nullptr;
+        }
+        firstSentMs = entry->firstSentMs;
+        return remove(*entry);
+    }
+
+    T* remove(Entry& entry)
+    {
+        T* item = entry.item;
+        entry = Entry{};
+        _count--;
+        return item;
+    }
+
+    Entry* find(int msgId)
+    {
+        for(auto& entry : _entries) {
+            if(entry.item && entry.msgId == msgId) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    /* Entry sent longest ago, nullptr if empty */
+    const Entry* oldest() const
+    {
+        const Entry* result = nullptr;
+        for(const auto& entry : _entries) {
+            if(entry.item && (!result || static_cast<int32_t>(entry.lastSentMs - result->lastSentMs) < 0)) {
+                result = &entry;
+            }
+        }
+        return result;
+    }
+
+    /* Restart all ack timeouts, e.g. after a reconnect */
+    void rebase(uint32_t nowMs)
+    {
+        for(auto& entry : _entries) {
+            if(entry.item) {
+                entry.lastSentMs = nowMs;
+            }
+        }
+    }
+
+    template<typename F>
+    void forEach(F&& fn)
+    {
+        for(auto& entry : _entries) {
+            if(entry.item) {
+                fn(entry);
+            }
+        }
+    }
+
+private:
+    std::array<Entry, N> _entries{};
+    size_t _count{0};
+};
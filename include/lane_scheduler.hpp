@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Picks the publish lane for the next send. High (control/alarm) goes
+ * first, but after BURST high messages in a row one bulk message gets
+ * through, so a chatty control topic cannot starve telemetry. A high
+ * message therefore waits for at most one bulk send, however large the
+ * RAM queue and flash backlog behind it are.
+ * Not thread safe, owned by the manager task.
+ */
+template<uint8_t BURST>
+class LaneScheduler {
+    static_assert(BURST > 0, "High lane needs at least one message per round");
+public:
+    enum class Lane : uint8_t {None, High, Bulk};
+
+    /* Lane to send from, None if neither has anything it may send */
+    Lane next(bool highWaiting, bool bulkReady) const noexcept
+    {
+        if(highWaiting && (!bulkReady || _highStreak < BURST)) {
+            return Lane::High;
+        }
+        return bulkReady ? Lane::Bulk : Lane::None;
+    }
+
+    /* A message of lane left the manager */
+    void sent(Lane lane) noexcept
+    {
+        if(lane == Lane::High) {
+            _highStreak = _highStreak < BURST ? _highStreak + 1 : BURST;
+        } else if(lane == Lane::Bulk) {
+            _highStreak = 0;
+        }
+    }
+
+private:
+    uint8_t _highStreak{0};
+};
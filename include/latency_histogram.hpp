@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Lock free log2 histogram of latencies in ms. Bucket i counts values
+ * below 2^i ms, the last bucket collects everything above.
+ * Writers and readers may live in different tasks.
+ */
+class LatencyHistogram {
+public:
+    static constexpr size_t BUCKETS = 20; // last bound ~4.4 min
+
+    void record(uint32_t ms) noexcept
+    {
+        _buckets[bucketOf(ms)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint32_t count() const noexcept
+    {
+        uint32_t total = 0;
+        for(const auto& bucket : _buckets) {
+            total += bucket.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    /* Upper bound in ms of the bucket holding the percentile, 0 if empty */
+    uint32_t percentile(uint8_t p) const noexcept
+    {
+        const uint32_t total = count();
+        if(total == 0) {
+            return 0;
+        }
+
+        const uint64_t target = (static_cast<uint64_t>(total) * p + 99) / 100;
+        uint64_t seen = 0;
+        for(size_t i = 0; i < BUCKETS; ++i) {
+            seen += _buckets[i].load(std::memory_order_relaxed);
+            if(seen >= target && seen > 0) {
+                return upperBound(i);
+            }
+        }
+        return upperBound(BUCKETS - 1);
+    }
+
+    uint32_t bucket(size_t i) const noexcept { return _buckets[i].load(std::memory_order_relaxed); }
+
+    void reset() noexcept
+    {
+        for(auto& bucket : _buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    static constexpr uint32_t upperBound(size_t i) noexcept
+    {
+        return i + 1 < BUCKETS ? (1u << i) : UINT32_MAX;
+    }
+
+private:
+    static constexpr size_t bucketOf(uint32_t ms) noexcept
+    {
+        size_t i = 0;
+        while(i + 1 < BUCKETS && ms >= (1u << i)) {
+            ++i;
+        }
+        return i;
+    }
+
+    std::array<std::atomic<uint32_t>, BUCKETS> _buckets{};
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Piecewise linear raw -> millivolt table. The calibration curve is sampled
+ * once at every 2^SEGMENT_BITS counts, a conversion is then one lookup and
+ * one interpolation instead of a call into the calibration scheme.
+ * Inputs may carry fraction bits (see sensor_filter.hpp) to keep the
+ * resolution gained by filtering.
+ */
+template<uint8_t ADC_BITS, uint8_t SEGMENT_BITS>
+class MillivoltLut {
+    static_assert(SEGMENT_BITS > 0 && SEGMENT_BITS < ADC_BITS, "Segment must be smaller than the ADC range");
+public:
+    static constexpr int32_t MAX_RAW = (1 << ADC_BITS) - 1;
+    static constexpr size_t POINTS = (size_t{1} << (ADC_BITS - SEGMENT_BITS)) + 1;
+
+    /**
+     * Sample rawToMv(int raw, int& mv) -> bool at every knot, the table stays
+     * invalid if any knot fails
+     */
+    template<typename Fn>
+    bool build(Fn&& rawToMv)
+    {
+        _valid = false;
+        for(size_t i = 0; i < POINTS; ++i) {
+            int mv = 0;
+            if(!rawToMv(knot(i), mv) || mv < 0 || mv > UINT16_MAX) {
+                return false;
+            }
+            _points[i] = static_cast<uint16_t>(mv);
+        }
+        _valid = true;
+        return true;
+    }
+
+    /* Millivolts of a raw value with fracBits fraction bits, clamped to the ADC range */
+    int32_t toMillivolts(int32_t raw, uint8_t fracBits = 0) const noexcept
+    {
+        const int32_t maxRaw = MAX_RAW << fracBits;
+        raw = raw < 0 ? 0 : raw > maxRaw ? maxRaw : raw;
+
+        size_t seg = static_cast<size_t>(raw >> (SEGMENT_BITS + fracBits));
+        if(seg >= POINTS - 1) {
+            seg = POINTS - 2;
+        }
+        const int32_t x0 = knot(seg) << fracBits;
+        const int32_t x1 = knot(seg + 1) << fracBits;
+        const int32_t y0 = _points[seg];
+        const int32_t y1 = _points[seg + 1];
+        // Round half up, the curve is monotonic so the delta is never negative
+        return y0 + ((y1 - y0) * (raw - x0) + (x1 - x0) / 2) / (x1 - x0);
+    }
+
+    bool isValid() const noexcept { return _valid; }
+
+private:
+    /* Raw value of knot i, the last one sits on the ADC maximum */
+    static constexpr int32_t knot(size_t i) noexcept
+    {
+        const int32_t raw = static_cast<int32_t>(i << SEGMENT_BITS);
+        return raw > MAX_RAW ? MAX_RAW : raw;
+    }
+
+    std::array<uint16_t, POINTS> _points{};
+    bool _valid{false};
+};
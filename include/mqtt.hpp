@@ -1,35 +1,65 @@
 #pragma once
 
 #include "wifi.hpp"
+#include "config.hpp"
+#include "publish_message.hpp"
+#include "topic_registry.hpp"
+#include "slot_pool.hpp"
+#include "coalesce_table.hpp"
+#include "reading_batch.hpp"
+#include "spsc_ring.hpp"
+#include "sample_stamp.hpp"
+#include "flash_log.hpp"
+#include "inflight_window.hpp"
+#include "lane_scheduler.hpp"
+#include "publish_metrics.hpp"
+#include "soil_calibration.hpp"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "esp_event.h"
 #include "mqtt_client.h"
 #include <atomic>
 #include <optional>
 #include <array>
-
-struct PublishMessage {
-    std::array<char, 64> topic;
-    std::array<char, 256> payload;
-    int qos;
-    int retain;
-    uint8_t retryCount;
-};
+#include <string_view>
 
 /* Manages mqtt connection */
 class MqttManager
 {
 public:
     enum class Status : uint8_t {Connected, Disconnected};
-    explicit MqttManager(QueueHandle_t statusQueue = nullptr, QueueHandle_t pubQueue = nullptr);
+    /* Publish lanes, High (control/alarm) is drained before Bulk (telemetry) */
+    enum class Priority : uint8_t {Bulk, High};
+    /* pubQueue items must be of type PublishSlot, commandQueue items of type CalibrationCommand */
+    explicit MqttManager(QueueHandle_t statusQueue = nullptr, QueueHandle_t pubQueue = nullptr,
+                         QueueHandle_t commandQueue = nullptr);
     ~MqttManager();
 
     /* Publish payload directly */
-    esp_err_t publish(const char* topic, const char* payload, int qos = 0) const;
-    /* Publish payload via queue */
-    esp_err_t queuePublish(const char* topic, const char* payload, int qos = 0) const;
+    esp_err_t publish(TopicId topic, std::string_view payload, int qos = 0) const;
+    /* Publish payload via queue, ESP_ERR_NO_MEM while the client outbox is over budget.
+       A full queue is handled by the topic's QueueFullPolicy */
+    esp_err_t queuePublish(TopicId topic, std::string_view payload, int qos = 0);
+    /* Publish payload via the queue of the given lane. High is never refused for outbox
+       backpressure and is sent within cfg::kMqttOutboxHighReserve above the budget */
+    esp_err_t queuePublish(TopicId topic, std::string_view payload, int qos, Priority priority);
+    /* Publish payload with an explicit queue full policy instead of the topic default */
+    esp_err_t queuePublish(TopicId topic, std::string_view payload, int qos, Priority priority, QueueFullPolicy policy);
+    /* Publish state via the bulk queue, replaces a still queued value of the same topic */
+    esp_err_t queueState(TopicId topic, std::string_view payload, int qos = 0);
+    /* Publish pipeline counters since boot, also published on the diagnostics topic */
+    const PublishMetrics& metrics() const noexcept { return _metrics; }
+    /* Add a reading to the current batch, published once per batch window
+       unless the channel deadband suppresses it.
+       Single producer task only with ReadingTransport::Ring */
+    esp_err_t queueReading(ReadingChannel channel, int32_t value);
+    /* Same as above with the stamp taken by the sensor at acquisition */
+    esp_err_t queueReading(ReadingChannel channel, int32_t value, const SampleStamp& stamp);
+    /* PUBACK latency percentile (0-100) in ms, bucket upper bound */
+    uint32_t ackLatencyMs(uint8_t percentile) const noexcept { return _metrics.ackLatency().percentile(percentile); }
     /* Get current connection status */
     Status current() const noexcept { return _status.load(); }
     /* Wait for connection to mqtt broker */
@@ -38,14 +68,124 @@ public:
     bool isValid() {return _initialized;};
 
 private:
-    /* Main Loop */
+    // qos, retain, topic length, payload length (2), topic, payload
+    static constexpr size_t FLASH_RECORD_LEN = 5 + topics::kMaxLen + sizeof(PublishMessage::payload);
+    static_assert(FLASH_RECORD_LEN <= FlashLog::MAX_RECORD_LEN, "Flash record too large");
+
+    /* Copy message into a pooled slot and queue it on its lane */
+    esp_err_t enqueue(TopicId topic, std::string_view payload, int qos, Priority priority, QueueFullPolicy policy);
+    /* Free slot for a producer, evicts the oldest queued message if the policy allows */
+    PublishSlot acquireSlot(Priority priority, QueueFullPolicy policy);
+    /* Queue a filled slot on its lane, released and counted as dropped if the queue stays full */
+    esp_err_t submit(PublishSlot msg, Priority priority, QueueFullPolicy policy);
+    /* Bulk producers are refused while the connected client's outbox is over budget */
+    bool bulkBackpressure() const;
+    /* Main Loop, blocks until wifi status, publish or mqtt events arrive */
     void run();
+    /* Start, resume or stop the mqtt client on wifi status changes */
+    void handleWifiStatus(WifiManager::Status wifiState);
+    enum class SendResult : uint8_t {Sent, Retry, Dropped, Backpressure};
+    enum class DrainStep : uint8_t {Sent, Empty, Blocked};
+
+    /* Drain high and bulk lanes, spills bulk to flash while disconnected */
+    void drainPublishQueue();
+    /* Any bulk message waiting in flash or RAM */
+    bool bulkWaiting() const;
+    /* Send one bulk message, live RAM queue before flash backlog, each paced by its bucket */
+    DrainStep sendBulk();
+    /* Send the head of a queue, the manager holds it until the publish succeeded */
+    DrainStep sendHead(QueueHandle_t queue, PublishSlot& head, Priority priority);
+    /* Publish or enqueue a single message of a lane, counts retries */
+    SendResult sendMessage(PublishMessage& msg, int& msgId, Priority priority);
+    /* Hand a message to the client, topic alias applied where possible.
+       topicLen is set to the topic bytes actually sent, 0 for an alias only publish */
+    int clientPublish(const PublishMessage& msg, size_t& topicLen);
+    /* Hand a sent slot to the in-flight window or back to the pool */
+    void completeSend(PublishSlot msg, int msgId);
+    /* Release slots acknowledged by PUBACK and record their latency */
+    void processAcks();
+    /* Count PUBACK timeouts of in-flight messages, drop them after too many attempts */
+    void checkAckTimeouts();
+    /* Refresh outbox usage, true while it exceeds budget bytes */
+    bool outboxOverBudget(size_t budget);
+    /* Move offline messages from the RAM queue to flash once it fills up */
+    void spillToFlash();
+    /* Replay one flash backlog message */
+    DrainStep replayOne();
+    /* Return a slot to the pool it came from */
+    void releaseSlot(PublishSlot msg);
+    /* Move queued readings into the batch and flush it when due */
+    void collectReadings();
+    /* Take the next reading from the configured transport */
+    bool nextReading(Reading& reading);
+    /* Encode the batch into publish slots and queue them with the batch topic's policy,
+       false if backpressure holds the batch back */
+    bool flushBatch();
+    /* Queue a metrics snapshot on the diagnostics topic when due */
+    void publishMetrics();
+    /* Time until the next retry or batch flush */
+    TickType_t nextWaitTicks() const;
+    /* Wake the manager task */
+    void wake();
+    /* Forward a message on a command topic to the command queue */
+    void handleCommand(const esp_mqtt_event_t& event);
     /* Mqtt event handler callback */
     static void eventHandler(void *event_handler_arg, esp_event_base_t event_base, int32_t event_id, void *event_data);
 
+    SlotPool<PublishMessage, cfg::kMqttPubQueueDepth> _pool;
+    SlotPool<PublishMessage, cfg::kPriorityQueueDepth> _priorityPool;
     QueueHandle_t _wifiStatusQueue{};
     QueueHandle_t _pubQueue{};
+    QueueHandle_t _priorityQueue{};
+    QueueHandle_t _commandQueue{};
+    CoalesceTable _coalesce;
+    // Taken from the queue but not yet sent, producers can evict queued messages safely
+    PublishSlot _bulkHead{};
+    PublishSlot _highHead{};
+    using Lanes = LaneScheduler<cfg::kHighPriorityBurst>;
+    using Lane = Lanes::Lane;
+    Lanes _lanes;
+    QueueHandle_t _readingQueue{};
+    SpscRing<Reading, cfg::kBatchMaxReadings> _readingRing;
+    ReadingBatch<cfg::kBatchMaxReadings> _batch;
+    std::array<DeadbandFilter, kChannelCount> _deadband{};
+    TickType_t _batchDeadline{};
+    bool _batchHeld{false}; // flush due but held back by outbox backpressure
+    uint32_t _batchSeq{0};
+    uint32_t _readingSeq{0};
+    PublishMetrics _metrics;
+    TickType_t _metricsDeadline{};
+    QueueSetHandle_t _queueSet{};
+    SemaphoreHandle_t _wakeSignal{};
+    std::optional<WifiManager::Status> _pendingWifiState;
+    bool _retryPending{false};
+    bool _outboxPending{false};
+    std::atomic<size_t> _outboxBytes{0};
+
+    struct AckEvent {
+        int msgId;
+        uint32_t ackMs;
+    };
+    QueueHandle_t _ackQueue{};
+    InflightWindow<PublishMessage, cfg::kInflightWindow> _inflight;
+    std::atomic<bool> _inflightRebase{false};
+
+    // Topics whose alias is known to the broker on the current connection
+    std::array<bool, kTopicCount> _aliasSent{};
+    uint16_t _aliasLimit{cfg::kMqttTopicAliasMax}; // aliases the broker accepts on this connection
+    std::atomic<bool> _aliasReset{false};
+    SemaphoreHandle_t _clientLock{}; // publish property and publish have to stay paired
+
+    FlashLog _flashLog{cfg::kFlashLogPartition.data()};
+    std::array<uint8_t, FLASH_RECORD_LEN> _flashRecord{};
+    PublishSlot _replaySlot{};
+    uint32_t _flashDropsCounted{0}; // FlashLog::dropped() already in the metrics
+    TokenBucket _liveBucket{cfg::kLiveRate};
+    TokenBucket _backlogBucket{cfg::kBacklogRate};
+    bool _livePaced{false};
+    bool _backlogPaced{false};
     esp_mqtt_client_handle_t _client{};
+    bool _clientStarted{false};
     std::atomic<bool> _terminate{false};
     std::atomic<Status> _status{Status::Disconnected};
     
@@ -59,8 +199,16 @@ private:
     static constexpr EventBits_t CONNECTED_BIT = BIT0;
     static constexpr EventBits_t DISCONNECTED_BIT =  BIT1;
     static constexpr uint8_t MAX_RETRY_COUNT = 3;
-    static constexpr uint32_t TASK_LOOP_DELAY_MS = 50;
+    static constexpr uint8_t QUEUE_SET_ADD_ATTEMPTS = 3;
     static constexpr uint32_t QUEUE_SEND_TIMEOUT_MS = 100;
-    static constexpr uint32_t QUEUE_RETRY_TIMEOUT_MS = 500;
+    static constexpr uint32_t RETRY_DELAY_MS = 500;
+    static constexpr uint32_t OUTBOX_POLL_MS = 100;
+    static constexpr int OUTBOX_FULL = -2; // esp_mqtt_client_enqueue result
+#if CONFIG_MQTT_PROTOCOL_5
+    // Only a blocking publish is sure to leave on the connection that knows the alias
+    static constexpr bool TOPIC_ALIASES = cfg::kMqttProtocol5 && cfg::kMqttPublishMode == cfg::PublishMode::Blocking;
+#else
+    static constexpr bool TOPIC_ALIASES = false;
+#endif
     
 };
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "reading_batch.hpp"
+#include "publish_metrics.hpp"
+#include <cstddef>
+#include <cstdint>
+
+/* Wire format of batched readings */
+enum class PayloadFormat : uint8_t {Text, Cbor};
+
+/**
+ * Encodes readings into a publish payload buffer without allocating.
+ * Both formats carry the same map:
+ *   s: message sequence number
+ *   t: timestamp of the first reading (ms since boot)
+ *   q: sequence number of the first reading, gaps mean readings were lost
+ *      after the deadband (suppressed readings take no number)
+ *   u: unit per channel, indexed by channel
+ *   r: [dt, channel, value, dq] per reading, dt relative to t, dq relative to q
+ * Text is JSON for debugging, Cbor is the compact binary form.
+ */
+namespace payload
+{
+    /* Encode as many readings as fit, returns number of readings written and sets len */
+    size_t encode(PayloadFormat format, const Reading* readings, size_t count, uint32_t seq,
+                  char* out, size_t cap, size_t& len);
+
+    size_t encodeText(const Reading* readings, size_t count, uint32_t seq, char* out, size_t cap, size_t& len);
+    size_t encodeCbor(const Reading* readings, size_t count, uint32_t seq, uint8_t* out, size_t cap, size_t& len);
+
+    /**
+     * Encode pipeline metrics as one map, false if it does not fit:
+     *   la: acquisition to enqueue ms [p50, p90, p99]
+     *   lq: enqueue to send latency ms [p50, p90, p99]
+     *   lk: PUBACK latency ms [p50, p99]
+     *   hw: publish queue high water mark
+     *   rt: publish retries
+     *   dr: drops indexed by DropReason
+     *   tx: bytes sent
+     *   rc: reconnects
+     *   up: seconds connected
+     */
+    bool encodeMetrics(PayloadFormat format, const MetricsSnapshot& metrics, char* out, size_t cap, size_t& len);
+} // namespace payload
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "topic_registry.hpp"
+#include <array>
+#include <cstdint>
+
+struct PublishMessage {
+    TopicId topic;          // name lives in the topic registry
+    std::array<char, 256> payload;
+    uint16_t payloadLen;    // payload may be binary
+    int qos;
+    int retain;
+    uint8_t retryCount;
+    uint32_t acquiredMs;    // oldest sample in the payload, 0 if unknown or not sensor data
+    uint32_t enqueuedMs;    // ms since boot, 0 if unknown (replayed from flash)
+};
+
+/* Publish queue items are pointers into the manager's slot pool */
+using PublishSlot = PublishMessage*;
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "latency_histogram.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Why data never reached the broker (Coalesced: merged into a newer value).
+ * Counted per message, except ReadingQueue (per reading, before batching)
+ * and FlashOverwrite (per stored record lost when the flash ring wrapped).
+ * New reasons are appended, the diagnostics payload is indexed by them.
+ */
+enum class DropReason : uint8_t {
+    QueueFull, OutboxBudget, Evicted, Coalesced, RetryLimit, AckTimeout, FlashWrite,
+    FlashOverwrite, ReadingQueue, Encode
+};
+
+inline constexpr size_t kDropReasonCount = 10;
+
+/* Plain copy of the metrics for encoding, see payload::encodeMetrics */
+struct MetricsSnapshot {
+    std::array<uint32_t, 3> sampleAgeMs;    // acquisition to enqueue p50, p90, p99
+    std::array<uint32_t, 3> sendLatencyMs;  // enqueue to send p50, p90, p99
+    std::array<uint32_t, 2> ackLatencyMs;   // send to PUBACK p50, p99
+    uint32_t queueHighWater;
+    uint32_t retries;
+    std::array<uint32_t, kDropReasonCount> drops;
+    uint32_t bytesSent;                     // topic and payload bytes handed to the client, wraps at 4 GiB
+    uint32_t reconnects;
+    uint32_t connectedS;                    // total time connected
+};
+
+/**
+ * Counters and histograms of the publish pipeline. All updates are
+ * relaxed atomics, producers, the mqtt event task and the manager task
+ * record without taking a lock. A snapshot is not taken atomically as
+ * a whole, fields may be a few updates apart.
+ */
+class PublishMetrics {
+public:
+    void recordSampleAge(uint32_t ms) noexcept { _sampleAge.record(ms); }
+    void recordSendLatency(uint32_t ms) noexcept { _sendLatency.record(ms); }
+    void recordAckLatency(uint32_t ms) noexcept { _ackLatency.record(ms); }
+    void countRetry() noexcept { _retries.fetch_add(1, std::memory_order_relaxed); }
+    void countBytes(uint32_t bytes) noexcept { _bytesSent.fetch_add(bytes, std::memory_order_relaxed); }
+
+    void countDrop(DropReason reason, uint32_t count = 1) noexcept
+    {
+        _drops[static_cast<size_t>(reason)].fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void noteQueueDepth(uint32_t depth) noexcept
+    {
+        uint32_t high = _queueHighWater.load(std::memory_order_relaxed);
+        while(depth > high && !_queueHighWater.compare_exchange_weak(high, depth, std::memory_order_relaxed)) {
+        }
+    }
+
+    void onConnected(uint32_t nowMs) noexcept
+    {
+        _connects.fetch_add(1, std::memory_order_relaxed);
+        _connectedSinceMs.store(nowMs, std::memory_order_relaxed);
+        _connected.store(true, std::memory_order_relaxed);
+    }
+
+    void onDisconnected(uint32_t nowMs) noexcept
+    {
+        if(_connected.exchange(false, std::memory_order_relaxed)) {
+            _connectedS.fetch_add((nowMs - _connectedSinceMs.load(std::memory_order_relaxed)) / 1000, std::memory_order_relaxed);
+        }
+    }
+
+    uint32_t drops(DropReason reason) const noexcept
+    {
+        return _drops[static_cast<size_t>(reason)].load(std::memory_order_relaxed);
+    }
+    const LatencyHistogram& ackLatency() const noexcept { return _ackLatency; }
+
+    MetricsSnapshot snapshot(uint32_t nowMs) const noexcept
+    {
+        MetricsSnapshot snap{};
+        snap.sampleAgeMs = {_sampleAge.percentile(50), _sampleAge.percentile(90), _sampleAge.percentile(99)};
+        snap.sendLatencyMs = {_sendLatency.percentile(50), _sendLatency.percentile(90), _sendLatency.percentile(99)};
+        snap.ackLatencyMs = {_ackLatency.percentile(50), _ackLatency.percentile(99)};
+        snap.queueHighWater = _queueHighWater.load(std::memory_order_relaxed);
+        snap.retries = _retries.load(std::memory_order_relaxed);
+        for(size_t i = 0; i < kDropReasonCount; ++i) {
+            snap.drops[i] = _drops[i].load(std::memory_order_relaxed);
+        }
+        snap.bytesSent = _bytesSent.load(std::memory_order_relaxed);
+
+        const uint32_t connects = _connects.load(std::memory_order_relaxed);
+        snap.reconnects = connects > 0 ? connects - 1 : 0;
+
+        snap.connectedS = _connectedS.load(std::memory_order_relaxed);
+        if(_connected.load(std::memory_order_relaxed)) {
+            snap.connectedS += (nowMs - _connectedSinceMs.load(std::memory_order_relaxed)) / 1000;
+        }
+        return snap;
+    }
+
+private:
+    LatencyHistogram _sampleAge;
+    LatencyHistogram _sendLatency;
+    LatencyHistogram _ackLatency;
+    std::atomic<uint32_t> _queueHighWater{0};
+    std::atomic<uint32_t> _retries{0};
+    std::array<std::atomic<uint32_t>, kDropReasonCount> _drops{};
+    std::atomic<uint32_t> _bytesSent{0};
+    std::atomic<uint32_t> _connects{0};
+    std::atomic<uint32_t> _connectedS{0};
+    std::atomic<uint32_t> _connectedSinceMs{0};
+    std::atomic<bool> _connected{false};
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/* Source of a reading inside a batch */
+enum class ReadingChannel : uint8_t {SoilMoisture = 0, SoilRaw = 1};
+
+inline constexpr size_t kChannelCount = 2;
+
+/* Unit of each channel, indexed by ReadingChannel */
+inline constexpr std::array<std::string_view, kChannelCount> kChannelUnits{"%", "raw"};
+
+struct Reading {
+    uint32_t timestampMs;   // ms since boot at acquisition
+    uint32_t seq;           // per device, numbered when the reading passes the deadband
+    ReadingChannel channel;
+    int32_t value;
+};
+
+/**
+ * Collects the readings of one flush window, see payload_encoder.hpp for
+ * the wire format
+ */
+template<size_t N>
+class ReadingBatch {
+public:
+    bool push(const Reading& reading)
+    {
+        if(full()) {
+            return false;
+        }
+        _readings[_count++] = reading;
+        return true;
+    }
+
+    void clear() noexcept { _count = 0; }
+    bool empty() const noexcept { return _count == 0; }
+    bool full() const noexcept { return _count >= N; }
+    size_t size() const noexcept { return _count; }
+    const Reading& operator[](size_t i) const { return _readings[i]; }
+    const Reading* data() const noexcept { return _readings.data(); }
+
+private:
+    std::array<Reading, N> _readings{};
+    size_t _count{0};
+};
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "esp_timer.h"
+#include <cstdint>
+
+/**
+ * Acquisition time of one sensor sample. The sequence number is assigned
+ * later, once a reading passes the deadband, see Reading::seq
+ */
+struct SampleStamp {
+    uint32_t acquiredMs;    // ms since boot, monotonic
+};
+
+/* Stamp a sample right after acquisition */
+inline SampleStamp stampSample()
+{
+    return {static_cast<uint32_t>(esp_timer_get_time() / 1000)};
+}
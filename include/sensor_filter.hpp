@@ -0,0 +1,147 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+
+/**
+ * Compile time filter chain for integer sensor samples, no allocation and
+ * no floating point. Values travel through the stages in fixed point with
+ * FRAC_BITS fraction bits, so decimation and smoothing keep the resolution
+ * they gain. Every stage has
+ *   bool push(int32_t in, int32_t& out)   true if out holds a new value
+ *   void reset()
+ */
+namespace filter
+{
+    inline constexpr uint8_t FRAC_BITS = 4;
+
+    constexpr int32_t toFixed(int32_t value) noexcept { return value * (1 << FRAC_BITS); }
+    constexpr int32_t fromFixed(int32_t value) noexcept
+    {
+        return (value >= 0 ? value + (1 << (FRAC_BITS - 1)) : value - (1 << (FRAC_BITS - 1))) / (1 << FRAC_BITS);
+    }
+
+    /* Average of N inputs, one output per N inputs */
+    template<size_t N>
+    class Oversample {
+        static_assert(N > 0, "Oversample needs at least one input");
+    public:
+        bool push(int32_t in, int32_t& out)
+        {
+            _sum += in;
+            if(++_count < N) {
+                return false;
+            }
+            out = static_cast<int32_t>((_sum + (_sum >= 0 ? N / 2 : -static_cast<int64_t>(N / 2))) / static_cast<int64_t>(N));
+            reset();
+            return true;
+        }
+
+        void reset() noexcept
+        {
+            _sum = 0;
+            _count = 0;
+        }
+
+    private:
+        int64_t _sum{0};
+        size_t _count{0};
+    };
+
+    /* Median of the last K inputs, rejects spikes shorter than K / 2 */
+    template<size_t K>
+    class MedianOf {
+        static_assert(K % 2 == 1, "Median window must be odd");
+    public:
+        bool push(int32_t in, int32_t& out)
+        {
+            _window[_next] = in;
+            _next = (_next + 1) % K;
+            if(_filled < K) {
+                _filled++;
+            }
+
+            // Insertion sort of a copy, K is small
+            std::array<int32_t, K> sorted{};
+            for(size_t i = 0; i < _filled; ++i) {
+                size_t j = i;
+                for(; j > 0 && sorted[j - 1] > _window[i]; --j) {
+                    sorted[j] = sorted[j - 1];
+                }
+                sorted[j] = _window[i];
+            }
+            out = sorted[_filled / 2];
+            return true;
+        }
+
+        void reset() noexcept
+        {
+            _next = 0;
+            _filled = 0;
+        }
+
+    private:
+        std::array<int32_t, K> _window{};
+        size_t _next{0};
+        size_t _filled{0};
+    };
+
+    /* Exponential moving average, alpha = 1 / 2^SHIFT, the first input sets the state */
+    template<uint8_t SHIFT>
+    class Ema {
+        static_assert(SHIFT < 16, "Ema shift out of range");
+    public:
+        bool push(int32_t in, int32_t& out)
+        {
+            if(!_primed) {
+                _state = in;
+                _primed = true;
+            } else {
+                _state += (in - _state) >> SHIFT;
+            }
+            out = _state;
+            return true;
+        }
+
+        void reset() noexcept { _primed = false; }
+
+    private:
+        int32_t _state{0};
+        bool _primed{false};
+    };
+
+    /* Stages run in order, a stage that holds its output back ends the push */
+    template<typename... Stages>
+    class FilterChain {
+    public:
+        /* Feed one sample in counts, true if a new output is available */
+        bool push(int32_t sample)
+        {
+            int32_t value = toFixed(sample);
+            const bool ready = std::apply([&value](auto&... stage) { return (stage.push(value, value) && ...); }, _stages);
+            if(ready) {
+                _output = value;
+                _hasOutput = true;
+            }
+            return ready;
+        }
+
+        void reset()
+        {
+            std::apply([](auto&... stage) { (stage.reset(), ...); }, _stages);
+            _hasOutput = false;
+        }
+
+        bool hasOutput() const noexcept { return _hasOutput; }
+        /* Latest output in fixed point and rounded to counts */
+        int32_t fixed() const noexcept { return _output; }
+        int32_t counts() const noexcept { return fromFixed(_output); }
+
+    private:
+        std::tuple<Stages...> _stages;
+        int32_t _output{0};
+        bool _hasOutput{false};
+    };
+} // namespace filter
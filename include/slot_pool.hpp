@@ -0,0 +1,73 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Fixed pool of preallocated slots. Free slot indices are kept in a
+ * FreeRTOS queue, so acquire/release are safe across tasks and only
+ * a pointer to the slot has to travel through the publish queue.
+ */
+template<typename T, size_t N>
+class SlotPool {
+    static_assert(N > 0 && N <= UINT8_MAX, "Slot index must fit into uint8_t");
+public:
+    SlotPool()
+    {
+        _free = xQueueCreate(N, sizeof(uint8_t));
+
+        if(!_free) {
+            ESP_LOGE("POOL", "Failed to create slot free list");
+            return;
+        }
+
+        for(size_t i = 0; i < N; ++i) {
+            uint8_t idx = static_cast<uint8_t>(i);
+            xQueueSend(_free, &idx, 0);
+        }
+    }
+
+    ~SlotPool()
+    {
+        if(_free) {
+            vQueueDelete(_free);
+        }
+    }
+
+    SlotPool(const SlotPool&) = delete;
+    SlotPool& operator=(const SlotPool&) = delete;
+
+    /* Take ownership of a free slot, nullptr if pool is exhausted */
+    T* acquire(TickType_t timeout = 0)
+    {
+        uint8_t idx{};
+        if(!_free || xQueueReceive(_free, &idx, timeout) != pdTRUE) {
+            return nullptr;
+        }
+        return &_slots[idx];
+    }
+
+    /* Return ownership of a slot to the pool */
+    void release(T* slot)
+    {
+        if(!owns(slot)) {
+            ESP_LOGE("POOL", "Released slot does not belong to pool");
+            return;
+        }
+        uint8_t idx = static_cast<uint8_t>(slot - _slots.data());
+        xQueueSend(_free, &idx, 0);
+    }
+
+    bool owns(const T* slot) const noexcept { return slot && slot >= _slots.data() && slot < _slots.data() + N; }
+    size_t available() const { return _free ? uxQueueMessagesWaiting(_free) : 0; }
+    bool isValid() const noexcept { return _free != nullptr; }
+    static constexpr size_t capacity() noexcept { return N; }
+
+private:
+    std::array<T, N> _slots{};
+    QueueHandle_t _free{};
+};
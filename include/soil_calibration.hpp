@@ -0,0 +1,42 @@
+#pragma once
+
+#include "calibration_command.hpp"
+#include "config.hpp"
+#include "esp_err.h"
+#include <cstdint>
+#include <optional>
+
+/* Dry and wet point of the probe in millivolts, a capacitive probe reads lower when wet */
+struct SoilCalibration {
+    int32_t airMv;
+    int32_t waterMv;
+
+    // Closer points would turn ADC noise into whole percent steps
+    static constexpr int32_t MIN_SPAN_MV = 100;
+
+    constexpr bool isValid() const noexcept { return waterMv >= 0 && airMv - waterMv >= MIN_SPAN_MV; }
+};
+
+/**
+ * SoilCalibration in NVS. Only touched at boot and when a point is
+ * captured, samples use the copy cached by the sensor.
+ */
+class CalibrationStore {
+public:
+    explicit CalibrationStore(const char* nvsNamespace = cfg::kCalibrationNamespace.data()) : _namespace(nvsNamespace) {}
+
+    /* Stored calibration, nullopt if none or not valid */
+    std::optional<SoilCalibration> load() const;
+    esp_err_t save(const SoilCalibration& calibration) const;
+
+private:
+    // Stored with a version byte, older layouts are ignored
+    struct Record {
+        uint8_t version;
+        SoilCalibration calibration;
+    };
+    static constexpr uint8_t RECORD_VERSION = 1;
+    static constexpr const char* KEY = "cal";
+
+    const char* _namespace;
+};
@@ -1,25 +1,64 @@
 #pragma once
 
 #include "esp_adc/adc_oneshot.h"
+#include "esp_adc/adc_continuous.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "config.hpp"
+#include "adc_frame.hpp"
+#include "millivolt_lut.hpp"
+#include "soil_calibration.hpp"
 #include "esp_log.h"
+#include <array>
 #include <cstdint>
 #include <atomic>
 #include <optional>
 #include "freertos_task.hpp"
+#include "sample_stamp.hpp"
+
+// Worst condition found in a sample, Good if none
+enum class SampleQuality : uint8_t {Good, Uncalibrated, Noisy, Clipped, Invalid};
+
+// All values of one acquisition
+struct SoilSample {
+    int raw;                // ADC counts after the cfg::SoilFilter chain
+    int millivolts;         // -1 without ADC calibration
+    int percent;            // moisture 0-100
+    SampleStamp stamp;
+    SampleQuality quality;
+};
 
 class SoilMoistureSensor {
 public:
     SoilMoistureSensor();
     ~SoilMoistureSensor();
 
-    // Read current moisture level (0-100%)
+    // One acquisition, all fields come from the same sample
+    SoilSample sample();
+    // Read current moisture level (0-100%), each call is a separate acquisition
     int readMoisturePercent();
     int readRawValue();
+    /* Capture a dry or wet point averaged over cfg::kCalibrationSamples acquisitions
+       and store it in NVS, or restore the defaults. Same task as sample() */
+    esp_err_t calibrate(CalibrationCommand command);
+    const SoilCalibration& calibration() const noexcept { return _calibration; }
     bool isValid() const { return _initialized; }
 
 private:
     // Initialize ADC
     bool initAdc();
+    bool initContinuous();
+    void initCalibration();
+    // Stored dry/wet points, defaults if there are none
+    void loadCalibration();
+    // Average of cfg::kCalibrationSamples unfiltered acquisitions, -1 if too many failed
+    int captureMillivolts();
+    // Feed one acquisition into the filter, stats count 0 on error
+    FrameStats acquire();
+    // One fresh DMA frame
+    FrameStats readFrame();
+    // Burst of cfg::kAdcSamplesPerRead oneshot reads
+    FrameStats readBurst();
     int map(int x, int in_min, int in_max, int out_min, int out_max);
     
     // Constants for calibration
@@ -28,11 +67,28 @@ private:
     static constexpr adc_bitwidth_t ADC_WIDTH = ADC_BITWIDTH_12;
     static constexpr adc_atten_t ADC_ATTEN = ADC_ATTEN_DB_12; // 0-3.3V range
     
-    // Calibration values
-    static constexpr int AIR_VALUE = 3000;    // TODO: Needs calibrations
-    static constexpr int WATER_VALUE = 1400;  // TODO: Needs calibration
+    // Dry/wet points in millivolts at the ADC pin until the probe is calibrated
+    static constexpr SoilCalibration DEFAULT_CALIBRATION{2550, 1250};
+
+    // Knot every 64 counts, 65 points
+    using MvLut = MillivoltLut<12, 6>;
+    // Nominal full scale of ADC_ATTEN, only used without eFuse calibration
+    static constexpr int NOMINAL_FULL_SCALE_MV = 3300;
     
-    // ADC handle
-    adc_oneshot_unit_handle_t _adcHandle;
+    // Spread within one frame above which a sample is flagged noisy
+    static constexpr int NOISY_SPREAD = 200;
+
+    static constexpr size_t FRAME_STORE_BYTES = cfg::kAdcFrameBytes * 4; // driver pool, a few frames
+
+    // ADC handle, depending on cfg::kAdcBackend
+    adc_oneshot_unit_handle_t _adcHandle{};
+    adc_continuous_handle_t _dmaHandle{};
+    std::array<uint8_t, cfg::kAdcFrameBytes> _frame{};
+    MvLut _mvLut;
+    bool _calibrated{false};
+    // Cached at boot, NVS is only written when a point is captured
+    SoilCalibration _calibration{DEFAULT_CALIBRATION};
+    CalibrationStore _calibrationStore;
+    cfg::SoilFilter _filter;
     bool _initialized{false};
 };
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+/* ESP32 cache line, keeps producer and consumer indices apart */
+inline constexpr size_t kCacheLineSize = 32;
+
+/**
+ * Lock free single producer / single consumer ring. push() must only be
+ * called from one task and pop() from one other task. Items are copied
+ * by value, no critical section is taken. Waking the consumer is left to
+ * the caller.
+ */
+template<typename T, size_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "Ring capacity must be a power of two");
+    static_assert(std::is_trivially_copyable_v<T>, "Ring items are copied without construction");
+public:
+    /* Producer side, false if the ring is full */
+    bool push(const T& item)
+    {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        if(tail - _headCache == N) {
+            _headCache = _head.load(std::memory_order_acquire);
+            if(tail - _headCache == N) {
+                return false;
+            }
+        }
+
+        _items[tail & MASK] = item;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /* Consumer side, false if the ring is empty */
+    bool pop(T& item)
+    {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        if(head == _tailCache) {
+            _tailCache = _tail.load(std::memory_order_acquire);
+            if(head == _tailCache) {
+                return false;
+            }
+        }
+
+        item = _items[head & MASK];
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /* Snapshot, exact only from the producer or consumer task */
+    size_t size() const noexcept
+    {
+        return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+    }
+    bool empty() const noexcept { return size() == 0; }
+    static constexpr size_t capacity() noexcept { return N; }
+
+private:
+    static constexpr size_t MASK = N - 1;
+
+    // Consumer owned
+    alignas(kCacheLineSize) std::atomic<size_t> _head{0};
+    size_t _tailCache{0};
+    // Producer owned
+    alignas(kCacheLineSize) std::atomic<size_t> _tail{0};
+    size_t _headCache{0};
+
+    alignas(kCacheLineSize) std::array<T, N> _items{};
+};
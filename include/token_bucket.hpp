@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+struct TokenBucketConfig {
+    uint32_t ratePerSec;    // refill rate in tokens, 0 = unlimited
+    uint32_t burst;         // bucket size in tokens
+};
+
+/**
+ * Rate limiter, one token per message. Tokens are kept in 1/1000 units
+ * so a refill of elapsed ms * rate per second stays in integers.
+ * Not thread safe, owned by a single task.
+ */
+class TokenBucket {
+public:
+    TokenBucket() = default;
+    explicit TokenBucket(const TokenBucketConfig& config)
+        : _config(config), _milliTokens(static_cast<uint64_t>(config.burst) * MILLI) {}
+
+    /* Refill and check for a whole token */
+    bool ready(uint32_t nowMs)
+    {
+        refill(nowMs);
+        return unlimited() || _milliTokens >= MILLI;
+    }
+
+    /* Consume one token, call after ready() */
+    void take()
+    {
+        if(_milliTokens >= MILLI) {
+            _milliTokens -= MILLI;
+        }
+    }
+
+    /* Time until ready() turns true */
+    uint32_t msUntilReady(uint32_t nowMs) const
+    {
+        if(unlimited()) {
+            return 0;
+        }
+        const uint64_t tokens = _milliTokens + static_cast<uint64_t>(nowMs - _lastMs) * _config.ratePerSec;
+        if(tokens >= MILLI) {
+            return 0;
+        }
+        return static_cast<uint32_t>((MILLI - tokens + _config.ratePerSec - 1) / _config.ratePerSec);
+    }
+
+private:
+    static constexpr uint64_t MILLI = 1000;
+
+    bool unlimited() const noexcept { return _config.ratePerSec == 0; }
+
+    void refill(uint32_t nowMs)
+    {
+        const uint64_t elapsed = nowMs - _lastMs;
+        _lastMs = nowMs;
+        _milliTokens = std::min<uint64_t>(_milliTokens + elapsed * _config.ratePerSec,
+                                          static_cast<uint64_t>(_config.burst) * MILLI);
+    }
+
+    TokenBucketConfig _config{0, 1};
+    uint64_t _milliTokens{0};
+    uint32_t _lastMs{0};
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "config.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+/* Handle of a registered topic, index into topics::kTable */
+enum class TopicId : uint8_t {SoilBatch, State, Diagnostics};
+
+inline constexpr size_t kTopicCount = 3;
+
+/* What queuePublish does when the queue or slot pool is full */
+enum class QueueFullPolicy : uint8_t {
+    Block,      // wait up to the send timeout, then drop the new message
+    DropNewest, // drop the new message immediately
+    DropOldest, // evict the oldest queued message of the lane
+    Coalesce    // replace the queued value of the same topic, else drop the new message
+};
+
+namespace topics
+{
+    inline constexpr size_t kMaxLen = 63; // without terminator
+
+    struct TopicSpec {
+        std::string_view name;
+        bool deviceScoped;          // composed as <root>/<device id>/<name>
+        QueueFullPolicy policy;     // default when queuePublish gets none
+    };
+
+    /* Composed, null terminated topic name */
+    struct Topic {
+        std::array<char, kMaxLen + 1> name{};
+        uint8_t len{0};
+        bool overflow{false};
+
+        constexpr const char* c_str() const noexcept { return name.data(); }
+        constexpr std::string_view view() const noexcept { return {name.data(), len}; }
+    };
+
+    /* Declared once, indexed by TopicId */
+    inline constexpr std::array<TopicSpec, kTopicCount> kSpecs{{
+        {cfg::kBatchTopic, false, QueueFullPolicy::DropOldest},
+        {cfg::kStateTopic, true, QueueFullPolicy::Coalesce},
+        {cfg::kDiagnosticsTopic, true, QueueFullPolicy::Coalesce},
+    }};
+
+    constexpr Topic compose(const TopicSpec& spec)
+    {
+        Topic topic{};
+        size_t n = 0;
+        auto append = [&](std::string_view part) {
+            for(char c : part) {
+                if(n >= kMaxLen) {
+                    topic.overflow = true;
+                    return;
+                }
+                topic.name[n++] = c;
+            }
+        };
+
+        if(spec.deviceScoped) {
+            append(cfg::kTopicRoot);
+            append("/");
+            append(cfg::kDeviceId);
+            append("/");
+        }
+        append(spec.name);
+        topic.len = static_cast<uint8_t>(n);
+        return topic;
+    }
+
+    constexpr std::array<Topic, kTopicCount> makeTable()
+    {
+        std::array<Topic, kTopicCount> table{};
+        for(size_t i = 0; i < kTopicCount; ++i) {
+            table[i] = compose(kSpecs[i]);
+        }
+        return table;
+    }
+
+    inline constexpr std::array<Topic, kTopicCount> kTable = makeTable();
+
+    constexpr bool fitsAll()
+    {
+        for(const auto& topic : kTable) {
+            if(topic.overflow || topic.len == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+    static_assert(fitsAll(), "Registered topic is empty or longer than topics::kMaxLen");
+
+    /* Subscribed command topics, inbound only so they have no TopicId */
+    inline constexpr Topic kCalibrate = compose({cfg::kCalibrateTopic, true, QueueFullPolicy::DropNewest});
+    static_assert(!kCalibrate.overflow, "Calibrate topic longer than topics::kMaxLen");
+
+    constexpr const Topic& get(TopicId id) { return kTable[static_cast<size_t>(id)]; }
+    constexpr const char* name(TopicId id) { return get(id).c_str(); }
+    constexpr QueueFullPolicy policy(TopicId id) { return kSpecs[static_cast<size_t>(id)].policy; }
+
+    /* Reverse lookup, only for records that carry the topic as text (flash backlog) */
+    inline std::optional<TopicId> find(std::string_view topic)
+    {
+        for(size_t i = 0; i < kTopicCount; ++i) {
+            if(kTable[i].view() == topic) {
+                return static_cast<TopicId>(i);
+            }
+        }
+        return std::nullopt;
+    }
+} // namespace topics
@@ -0,0 +1,22 @@
+#include "calibration_command.hpp"
+
+std::optional<CalibrationCommand> parseCalibrationCommand(std::string_view payload)
+{
+    constexpr std::string_view whitespace{" \t\r\n"};
+    const size_t first = payload.find_first_not_of(whitespace);
+    if (first == std::string_view::npos) {
+        return std::nullopt;
+    }
+    payload = payload.substr(first, payload.find_last_not_of(whitespace) - first + 1);
+
+    if (payload == "dry") {
+        return CalibrationCommand::CaptureDry;
+    }
+    if (payload == "wet") {
+        return CalibrationCommand::CaptureWet;
+    }
+    if (payload == "reset") {
+        return CalibrationCommand::Reset;
+    }
+    return std::nullopt;
+}
@@ -0,0 +1,321 @@
+#include "flash_log.hpp"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include <algorithm>
+
+FlashLog::FlashLog(const char* partitionLabel)
+{
+    _partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, partitionLabel);
+    if (!_partition) {
+        ESP_LOGW("FLASHLOG", "Partition %s not found, store and forward disabled", partitionLabel);
+        return;
+    }
+
+    _sectorCount = _partition->size / SECTOR_SIZE;
+    if (_sectorCount < 2) {
+        ESP_LOGE("FLASHLOG", "Partition %s needs at least two sectors", partitionLabel);
+        return;
+    }
+
+    _mounted = mount();
+    if (_mounted) {
+        ESP_LOGI("FLASHLOG", "Mounted %s: %zu sectors, %zu pending records", partitionLabel, _sectorCount, _pending);
+    } else {
+        ESP_LOGE("FLASHLOG", "Failed to mount %s", partitionLabel);
+    }
+}
+
+bool FlashLog::mount()
+{
+    // Newest sector is the write sector
+    SectorHeader header{};
+    bool found = false;
+    for (size_t s = 0; s < _sectorCount; ++s) {
+        if (sectorValid(s, header) && (!found || header.seq > _seq)) {
+            found = true;
+            _seq = header.seq;
+            _writeSector = s;
+        }
+    }
+
+    if (!found) {
+        _seq = 0;
+        _readSector = 0;
+        _readOffset = FIRST_RECORD;
+        return openSector(0) == ESP_OK;
+    }
+
+    // Oldest sector is the first valid one after the writer in ring order
+    _readSector = _writeSector;
+    for (size_t s = nextSector(_writeSector); s != _writeSector; s = nextSector(s)) {
+        if (sectorValid(s, header)) {
+            _readSector = s;
+            break;
+        }
+    }
+    _readOffset = FIRST_RECORD;
+
+    _pending = 0;
+    for (size_t s = _readSector; ; s = nextSector(s)) {
+        size_t sectorPending = 0;
+        if (sectorValid(s, header)) {
+            const size_t end = scanSector(s, FIRST_RECORD, sectorPending);
+            if (s == _writeSector) {
+                _writeOffset = end;
+            }
+        }
+        _pending += sectorPending;
+        if (s == _writeSector) {
+            break;
+        }
+    }
+
+    return true;
+}
+
+esp_err_t FlashLog::openSector(size_t sector)
+{
+    esp_err_t err = esp_partition_erase_range(_partition, address(sector, 0), SECTOR_SIZE);
+    if (err != ESP_OK) {
+        ESP_LOGE("FLASHLOG", "Failed to erase sector %zu: %s", sector, esp_err_to_name(err));
+        return err;
+    }
+
+    const SectorHeader header{SECTOR_MAGIC, _seq + 1};
+    err = esp_partition_write(_partition, address(sector, 0), &header, sizeof(header));
+    if (err != ESP_OK) {
+        ESP_LOGE("FLASHLOG", "Failed to write sector header %zu: %s", sector, esp_err_to_name(err));
+        return err;
+    }
+
+    _seq = header.seq;
+    _writeSector = sector;
+    _writeOffset = FIRST_RECORD;
+    return ESP_OK;
+}
+
+esp_err_t FlashLog::advanceWriteSector()
+{
+    const size_t next = nextSector(_writeSector);
+
+    // Ring full, the oldest sector gets overwritten
+    if (next == _readSector) {
+        size_t lost = 0;
+        scanSector(_readSector, _readOffset, lost);
+        if (lost) {
+            ESP_LOGW("FLASHLOG", "Ring full, dropping %zu oldest records", lost);
+        }
+        _pending -= std::min(lost, _pending);
+        _dropped += lost;
+        _readSector = nextSector(next);
+        _readOffset = FIRST_RECORD;
+        _peeked = false;
+    }
+
+    return openSector(next);
+}
+
+esp_err_t FlashLog::append(const void* data, size_t len)
+{
+    if (!_mounted) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!data || len == 0 || len > MAX_RECORD_LEN) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if (_writeOffset + recordSize(len) > SECTOR_SIZE) {
+        esp_err_t err = advanceWriteSector();
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    // Header first: a power loss before the data is complete leaves a crc mismatch
+    const RecordHeader header{
+        static_cast<uint16_t>(len),
+        RECORD_MARKER,
+        esp_rom_crc32_le(0, static_cast<const uint8_t*>(data), len),
+        ERASED32
+    };
+    const size_t addr = address(_writeSector, _writeOffset);
+
+    esp_err_t err = esp_partition_write(_partition, addr, &header, offsetof(RecordHeader, consumed));
+    if (err == ESP_OK) {
+        err = esp_partition_write(_partition, addr + sizeof(RecordHeader), data, len);
+    }
+
+    // Space is used either way, the record fails its crc if incomplete
+    _writeOffset += recordSize(len);
+
+    if (err != ESP_OK) {
+        ESP_LOGE("FLASHLOG", "Failed to append record: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    _pending++;
+    return ESP_OK;
+}
+
+esp_err_t FlashLog::peek(void* out, size_t cap, size_t& len)
+{
+    len = 0;
+    if (!_mounted) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    while (seekReadable()) {
+        RecordHeader header{};
+        readHeader(_readSector, _readOffset, header);
+        if (header.len > cap) {
+            // Caller can never read it, skip instead of blocking the log
+            ESP_LOGW("FLASHLOG", "Skipping record of %u bytes, buffer holds %zu", header.len, cap);
+            _readOffset += recordSize(header.len);
+            _pending -= std::min<size_t>(1, _pending);
+            continue;
+        }
+
+        esp_err_t err = esp_partition_read(_partition, address(_readSector, _readOffset) + sizeof(RecordHeader), out, header.len);
+        if (err != ESP_OK) {
+            return err;
+        }
+
+        if (esp_rom_crc32_le(0, static_cast<const uint8_t*>(out), header.len) == header.crc) {
+            len = header.len;
+            _peeked = true;
+            return ESP_OK;
+        }
+
+        // Torn record, already left out of the pending count at mount
+        ESP_LOGW("FLASHLOG", "Skipping corrupt record in sector %zu", _readSector);
+        _readOffset += recordSize(header.len);
+    }
+
+    _pending = 0;
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t FlashLog::pop()
+{
+    if (!_mounted || !_peeked) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    RecordHeader header{};
+    readHeader(_readSector, _readOffset, header);
+
+    // Clearing bits needs no erase
+    const uint32_t consumed = 0;
+    esp_err_t err = esp_partition_write(
+        _partition,
+        address(_readSector, _readOffset) + offsetof(RecordHeader, consumed),
+        &consumed,
+        sizeof(consumed)
+    );
+    if (err != ESP_OK) {
+        ESP_LOGE("FLASHLOG", "Failed to mark record consumed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    _readOffset += recordSize(header.len);
+    _pending -= std::min<size_t>(1, _pending);
+    _peeked = false;
+    return ESP_OK;
+}
+
+bool FlashLog::seekReadable()
+{
+    for (;;) {
+        const bool inWriteSector = _readSector == _writeSector;
+        if (inWriteSector && _readOffset >= _writeOffset) {
+            return false;
+        }
+
+        RecordHeader header{};
+        RecordState state = _readOffset + sizeof(RecordHeader) <= SECTOR_SIZE
+                          ? readHeader(_readSector, _readOffset, header)
+                          : RecordState::Free;
+
+        switch (state) {
+            case RecordState::Valid:
+                return true;
+            case RecordState::Consumed:
+                _readOffset += recordSize(header.len);
+                break;
+            case RecordState::Free:
+            case RecordState::Corrupt:
+                // End of this sector
+                if (inWriteSector) {
+                    return false;
+                }
+                _readSector = nextSector(_readSector);
+                _readOffset = FIRST_RECORD;
+                break;
+        }
+    }
+}
+
+bool FlashLog::sectorValid(size_t sector, SectorHeader& header) const
+{
+    return esp_partition_read(_partition, address(sector, 0), &header, sizeof(header)) == ESP_OK
+        && header.magic == SECTOR_MAGIC
+        && header.seq != ERASED32;
+}
+
+FlashLog::RecordState FlashLog::readHeader(size_t sector, size_t offset, RecordHeader& header) const
+{
+    if (esp_partition_read(_partition, address(sector, offset), &header, sizeof(header)) != ESP_OK) {
+        return RecordState::Corrupt;
+    }
+    if (header.len == ERASED16 && header.marker == ERASED16) {
+        return RecordState::Free;
+    }
+    if (header.marker != RECORD_MARKER || header.len == 0 || header.len > MAX_RECORD_LEN
+        || offset + recordSize(header.len) > SECTOR_SIZE) {
+        return RecordState::Corrupt;
+    }
+    return header.consumed == ERASED32 ? RecordState::Valid : RecordState::Consumed;
+}
+
+bool FlashLog::crcMatches(size_t sector, size_t offset, const RecordHeader& header) const
+{
+    // Chunked so verification needs no record sized buffer
+    uint8_t chunk[CRC_CHUNK];
+    uint32_t crc = 0;
+    size_t addr = address(sector, offset) + sizeof(RecordHeader);
+
+    for (size_t left = header.len; left > 0; ) {
+        const size_t n = std::min(left, sizeof(chunk));
+        if (esp_partition_read(_partition, addr, chunk, n) != ESP_OK) {
+            return false;
+        }
+        crc = esp_rom_crc32_le(crc, chunk, n);
+        addr += n;
+        left -= n;
+    }
+
+    return crc == header.crc;
+}
+
+size_t FlashLog::scanSector(size_t sector, size_t offset, size_t& pending) const
+{
+    RecordHeader header{};
+    while (offset + sizeof(RecordHeader) <= SECTOR_SIZE) {
+        switch (readHeader(sector, offset, header)) {
+            case RecordState::Free:
+                return offset;
+            case RecordState::Corrupt:
+                // Nothing after a corrupt header can be trusted
+                return SECTOR_SIZE;
+            case RecordState::Valid:
+                if (crcMatches(sector, offset, header)) {
+                    pending++;
+                }
+                break;
+            case RecordState::Consumed:
+                break;
+        }
+        offset += recordSize(header.len);
+    }
+    return SECTOR_SIZE;
+}
@@ -7,9 +7,30 @@
 #include "freertos/task.h"
 #include "freertos/queue.h"
 #include "esp_log.h" 
+#include <cstdio>
+
+struct PublishTaskArgs {
+    MqttManager* mqttManager;
+    QueueHandle_t commandQueue; // CalibrationCommand from the calibrate topic
+};
+
+// Run a calibration command and report the resulting points on the state topic
+static void runCalibration(SoilMoistureSensor& soilSensor, MqttManager& mqttManager, CalibrationCommand command) {
+    const esp_err_t result = soilSensor.calibrate(command);
+    const SoilCalibration& calibration = soilSensor.calibration();
+
+    char payload[96];
+    const int len = snprintf(payload, sizeof(payload), "{\"calibration\":{\"dry\":%ld,\"wet\":%ld,\"ok\":%s}}",
+                             static_cast<long>(calibration.airMv), static_cast<long>(calibration.waterMv),
+                             result == ESP_OK ? "true" : "false");
+    if (len > 0 && static_cast<size_t>(len) < sizeof(payload)) {
+        mqttManager.queueState(TopicId::State, std::string_view{payload, static_cast<size_t>(len)}, 1);
+    }
+}
 
 void taskPublish(void* arg) {
-    auto* mqttManager = static_cast<MqttManager*>(arg);
+    const auto* args = static_cast<const PublishTaskArgs*>(arg);
+    auto* mqttManager = args->mqttManager;
     
     SoilMoistureSensor soilSensor{};
     
@@ -19,32 +40,37 @@ void taskPublish(void* arg) {
         return;
     }
 
-    char buffer[16];
-    
+    constexpr TickType_t samplePeriod = pdMS_TO_TICKS(10000); // Read every 10 seconds
     for(;;) {
+        const TickType_t started = xTaskGetTickCount();
         if (mqttManager->waitForConnection(pdMS_TO_TICKS(5000))) {
-            // Read soil moisture 
-            int moisturePercent = soilSensor.readMoisturePercent();
-            int rawValue = soilSensor.readRawValue();
+            // Read soil moisture, percent and raw value from one acquisition
+            const SoilSample sample = soilSensor.sample();
             
-            if (moisturePercent >= 0) {
-                snprintf(buffer, sizeof(buffer), "%d", moisturePercent);
-                esp_err_t result1 = mqttManager->queuePublish("sensor/soil/moisture", buffer, 0);
-                
-                snprintf(buffer, sizeof(buffer), "%d", rawValue);
-                esp_err_t result2 = mqttManager->queuePublish("sensor/soil/raw", buffer, 0);
+            if (sample.quality != SampleQuality::Invalid) {
+                // Readings are batched and published once per window by the mqtt manager
+                esp_err_t result1 = mqttManager->queueReading(ReadingChannel::SoilMoisture, sample.percent, sample.stamp);
+                esp_err_t result2 = mqttManager->queueReading(ReadingChannel::SoilRaw, sample.raw, sample.stamp);
                 
                 if (result1 != ESP_OK || result2 != ESP_OK) {
-                    ESP_LOGW("PUBLISH", "Failed to publish soil moisture data");
+                    ESP_LOGW("PUBLISH", "Failed to queue soil moisture data");
                 } else {
-                    ESP_LOGI("PUBLISH", "Soil moisture: %d%%, Raw: %d", moisturePercent, rawValue);
+                    ESP_LOGI("PUBLISH", "Soil moisture: %d%%, Raw: %d, %d mV, quality %u", sample.percent, sample.raw,
+                             sample.millivolts, static_cast<unsigned>(sample.quality));
                 }
             } else {
                 ESP_LOGW("PUBLISH", "Failed to read soil moisture sensor");
             }
         }
         
-        vTaskDelay(pdMS_TO_TICKS(10000)); // Read every 10 seconds
+        // Calibration commands are handled between samples, never on the sample path
+        CalibrationCommand command{};
+        for (TickType_t elapsed = xTaskGetTickCount() - started; elapsed < samplePeriod;
+             elapsed = xTaskGetTickCount() - started) {
+            if (xQueueReceive(args->commandQueue, &command, samplePeriod - elapsed) == pdTRUE) {
+                runCalibration(soilSensor, *mqttManager, command);
+            }
+        }
     }
 }
 
@@ -58,16 +84,17 @@ extern "C" void app_main() {
     ESP_ERROR_CHECK(ret);
 
     QueueHandle_t wifiStatusQ = xQueueCreate(4, sizeof(WifiManager::Status));
-    QueueHandle_t mqttPubQ = xQueueCreate(10, sizeof(PublishMessage));
+    QueueHandle_t mqttPubQ = xQueueCreate(cfg::kMqttPubQueueDepth, sizeof(PublishSlot));
+    QueueHandle_t commandQ = xQueueCreate(2, sizeof(CalibrationCommand));
 
-    if((wifiStatusQ == nullptr) || (mqttPubQ == nullptr)) {
+    if((wifiStatusQ == nullptr) || (mqttPubQ == nullptr) || (commandQ == nullptr)) {
         ESP_LOGE("MAIN", "Failed to create queues!");
         esp_restart();
         return;
     }
 
     static WifiManager wifiManager{wifiStatusQ};
-    static MqttManager mqttManager{wifiStatusQ, mqttPubQ};
+    static MqttManager mqttManager{wifiStatusQ, mqttPubQ, commandQ};
 
     if(!wifiManager.isValid() || !mqttManager.isValid()) {
         ESP_LOGE("MAIN", "Failed to initialize managers!");
@@ -75,13 +102,15 @@ extern "C" void app_main() {
         return;
     }
 
+    static PublishTaskArgs publishArgs{&mqttManager, commandQ};
+
     // Example publish task
     // TODO: Use RAII Task Wrapper
     xTaskCreatePinnedToCore(
         taskPublish,
         "Publish",
-        2048,
-        &mqttManager,
+        4096, // NVS writes while calibrating
+        &publishArgs,
         2,
         nullptr,
         tskNO_AFFINITY
@@ -1,9 +1,21 @@
 #include "mqtt.hpp"
 #include "config.hpp"
+#include "esp_timer.h"
 #include <algorithm>
 
-MqttManager::MqttManager(QueueHandle_t statusQueue, QueueHandle_t pubQueue) 
-    : _wifiStatusQueue(statusQueue), _pubQueue(pubQueue)
+static uint32_t nowMs()
+{
+    return static_cast<uint32_t>(esp_timer_get_time() / 1000);
+}
+
+/* Round up to whole ticks, a wait of a few ms must not turn into a zero tick poll */
+static TickType_t ticksFromMs(uint32_t ms)
+{
+    return (ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+}
+
+MqttManager::MqttManager(QueueHandle_t statusQueue, QueueHandle_t pubQueue, QueueHandle_t commandQueue)
+    : _wifiStatusQueue(statusQueue), _pubQueue(pubQueue), _commandQueue(commandQueue)
 {
     // Create config
     esp_mqtt_client_config_t mqtt_cfg = {};
@@ -16,6 +28,16 @@ MqttManager::MqttManager(QueueHandle_t statusQueue, QueueHandle_t pubQueue)
     mqtt_cfg.network.disable_auto_reconnect = false,
     mqtt_cfg.session.keepalive = 30,
     mqtt_cfg.task.priority = 5;
+    if constexpr (cfg::kMqttPersistentSession) {
+        // Broker keys the session on the client id. The client's default id is built from
+        // the chip MAC, so it survives reboots and differs between boards with the same config
+        mqtt_cfg.session.disable_clean_session = true;
+    }
+#if CONFIG_MQTT_PROTOCOL_5
+    if constexpr (cfg::kMqttProtocol5) {
+        mqtt_cfg.session.protocol_ver = MQTT_PROTOCOL_V_5;
+    }
+#endif
 
     _client = esp_mqtt_client_init(&mqtt_cfg);
     if (!_client) {
@@ -23,6 +45,15 @@ MqttManager::MqttManager(QueueHandle_t statusQueue, QueueHandle_t pubQueue)
         return;
     }
 
+#if CONFIG_MQTT_PROTOCOL_5
+    // MQTT 5 ends the session on disconnect unless an expiry interval is set
+    if constexpr (cfg::kMqttProtocol5 && cfg::kMqttPersistentSession) {
+        esp_mqtt5_connection_property_config_t connectProperty{};
+        connectProperty.session_expiry_interval = cfg::kMqttSessionExpiryS;
+        esp_mqtt5_client_set_connect_property(_client, &connectProperty);
+    }
+#endif
+
     // event callback
     esp_mqtt_client_register_event(
         _client,
@@ -31,6 +62,47 @@ MqttManager::MqttManager(QueueHandle_t statusQueue, QueueHandle_t pubQueue)
         this
     );
 
+    // Report on change filter per reading channel
+    for (size_t i = 0; i < _deadband.size(); ++i) {
+        _deadband[i] = DeadbandFilter{cfg::kDeadband[i]};
+    }
+
+    // Single wait point for the manager task: wifi status queue + wake signal
+    if constexpr (cfg::kReadingTransport == cfg::ReadingTransport::Queue) {
+        _readingQueue = xQueueCreate(cfg::kBatchMaxReadings, sizeof(Reading));
+    }
+    _ackQueue = xQueueCreate(cfg::kInflightWindow * 2, sizeof(AckEvent));
+    _priorityQueue = xQueueCreate(cfg::kPriorityQueueDepth, sizeof(PublishSlot));
+    _wakeSignal = xSemaphoreCreateBinary();
+    _clientLock = xSemaphoreCreateMutex();
+    UBaseType_t setLength = 1;
+    if (_wifiStatusQueue) {
+        setLength += uxQueueMessagesWaiting(_wifiStatusQueue) + uxQueueSpacesAvailable(_wifiStatusQueue);
+    }
+    _queueSet = xQueueCreateSet(setLength);
+    const bool readingsReady = _readingQueue || cfg::kReadingTransport == cfg::ReadingTransport::Ring;
+    if (!readingsReady || !_ackQueue || !_priorityQueue || !_wakeSignal || !_clientLock || !_queueSet) {
+        ESP_LOGE("MQTT", "Failed to create manager wait set!");
+        return;
+    }
+    xQueueAddToSet(_wakeSignal, _queueSet);
+
+    if (_wifiStatusQueue) {
+        // Set members have to be empty when added, keep the latest status that was already reported
+        bool added = false;
+        for (uint8_t attempt = 0; attempt < QUEUE_SET_ADD_ATTEMPTS && !added; ++attempt) {
+            WifiManager::Status wifiState{};
+            while (xQueueReceive(_wifiStatusQueue, &wifiState, 0) == pdTRUE) {
+                _pendingWifiState = wifiState;
+            }
+            added = xQueueAddToSet(_wifiStatusQueue, _queueSet) == pdPASS;
+        }
+        if (!added) {
+            ESP_LOGE("MQTT", "Failed to add wifi status queue to wait set!");
+            return;
+        }
+    }
+
     _task.emplace(
         "MQTT Manager",
         4096,
@@ -39,13 +111,42 @@ MqttManager::MqttManager(QueueHandle_t statusQueue, QueueHandle_t pubQueue)
         tskNO_AFFINITY
     );
 
-    _initialized = _eg.getHandle() && _task && _task->getHandle();
+    _initialized = _eg.getHandle() && _pool.isValid() && _priorityPool.isValid() && _queueSet && _task && _task->getHandle();
     ESP_LOGI("MQTT", "Mqtt Manager initialized successfully!");
 }
 
 MqttManager::~MqttManager()
 {
     _terminate.store(true); // delete task
+    wake();
+    _task.reset();
+
+    if (_queueSet) {
+        if (_wifiStatusQueue) {
+            xQueueReset(_wifiStatusQueue);
+            xQueueRemoveFromSet(_wifiStatusQueue, _queueSet);
+        }
+        if (_wakeSignal) {
+            xSemaphoreTake(_wakeSignal, 0);
+            xQueueRemoveFromSet(_wakeSignal, _queueSet);
+        }
+        vQueueDelete(_queueSet);
+    }
+    if (_wakeSignal) {
+        vSemaphoreDelete(_wakeSignal);
+    }
+    if (_readingQueue) {
+        vQueueDelete(_readingQueue);
+    }
+    if (_ackQueue) {
+        vQueueDelete(_ackQueue);
+    }
+    if (_priorityQueue) {
+        vQueueDelete(_priorityQueue);
+    }
+    if (_clientLock) {
+        vSemaphoreDelete(_clientLock);
+    }
 
     esp_mqtt_client_unregister_event(
         _client,
@@ -70,129 +171,918 @@ bool MqttManager::waitForConnection(TickType_t timeout)
 
 void MqttManager::run()
 {
-    // TODO: Make queue operations non blocking to handle termination properly
-    WifiManager::Status wifiState{};
-    PublishMessage pubMsg{};
-    bool processedQueue = false;
+    _metricsDeadline = xTaskGetTickCount() + pdMS_TO_TICKS(cfg::kMetricsIntervalMs);
+    if (_pendingWifiState) {
+        handleWifiStatus(*_pendingWifiState);
+        _pendingWifiState.reset();
+    }
 
     for(;;) {
+        // Sleep until something happens, only retries and batch flushes need a timeout
+        QueueSetMemberHandle_t active = xQueueSelectFromSet(_queueSet, nextWaitTicks());
+
         if(_terminate.load()) {
             ESP_LOGI("MQTT", "Terminating mqtt manager task");
             return;
         };
         
-        // Handle wifi status change
-        if(xQueueReceive(_wifiStatusQueue, &wifiState, pdMS_TO_TICKS(500))) {
-            processedQueue = true;
-            if (wifiState == WifiManager::Status::Connected && _status.load() == Status::Disconnected) {
+        if (active == _wifiStatusQueue) {
+            WifiManager::Status wifiState{};
+            if (xQueueReceive(_wifiStatusQueue, &wifiState, 0) == pdTRUE) {
+                handleWifiStatus(wifiState);
+            }
+        } else if (active == _wakeSignal) {
+            xSemaphoreTake(_wakeSignal, 0);
+        }
+
+        processAcks();
+        collectReadings();
+        checkAckTimeouts();
+        publishMetrics();
+        drainPublishQueue();
+    }
+}
+
+void MqttManager::handleWifiStatus(WifiManager::Status wifiState)
+{
+    if constexpr (cfg::kMqttPersistentSession) {
+        // The client keeps running across wifi flaps and a short one may not even drop
+        // the TCP connection, so only MQTT_EVENT_CONNECTED/DISCONNECTED change the status
+        if (wifiState == WifiManager::Status::Disconnected && _status.load() == Status::Connected) {
+            ESP_LOGI("MQTT", "Wifi disconnected, MQTT session kept for resume");
+        } else if (wifiState == WifiManager::Status::Connected) {
+            if (!_clientStarted) {
                 ESP_LOGI("MQTT", "Wifi connected, starting MQTT client");
-                esp_mqtt_client_start(_client);
-            } else if (wifiState == WifiManager::Status::Disconnected && _status.load() == Status::Connected) {
-                ESP_LOGI("MQTT", "Wifi disconnected, stopping MQTT client");
-                esp_mqtt_client_stop(_client);
-                _status.store(Status::Disconnected);
-            }   
-        } 
-
-        // Handle publish messages from queue
-        if(_pubQueue) {
-            while(xQueueReceive(_pubQueue, &pubMsg, 0) == pdTRUE) {
-                processedQueue = true;
-                if(_status.load() == Status::Connected) {
-                    esp_err_t result = esp_mqtt_client_publish(
-                        _client,
-                        pubMsg.topic.data(),
-                        pubMsg.payload.data(),
-                        0,
-                        pubMsg.qos,
-                        pubMsg.retain
-                    );
-
-                    if(result < 0) {
-                        ESP_LOGE("MQTT", "Failed to publish topic %s with payload %s", pubMsg.topic, pubMsg.payload);
-                        if (pubMsg.retryCount < MAX_RETRY_COUNT) {
-                            pubMsg.retryCount++;
-                            xQueueSendToFront(_pubQueue, &pubMsg, pdMS_TO_TICKS(QUEUE_RETRY_TIMEOUT_MS));
-                        } else {
-                            ESP_LOGE("MQTT", "Retry limit reached for topic %s with payload %s, dropping.", pubMsg.topic, pubMsg.payload);
-                        }
-                    } else {
-                        ESP_LOGD("MQTT", "Published topic %s with payload %s", pubMsg.topic, pubMsg.payload);
-                    }
-                } else {
-                    ESP_LOGD("MQTT", "MQTT offline, keeping message for later: %s", pubMsg.topic);
-                    if (xQueueSendToBack(_pubQueue, &pubMsg, 0) != pdTRUE) {
-                        ESP_LOGW("MQTT", "Queue full, dropping offline message");
-                    }
-                }
+                _clientStarted = esp_mqtt_client_start(_client) == ESP_OK;
+            } else if (_status.load() == Status::Disconnected) {
+                // Skip the client's reconnect back off, the session and outbox are still there.
+                // Only possible while it waits to reconnect, otherwise it is already connecting
+                const esp_err_t err = esp_mqtt_client_reconnect(_client);
+                ESP_LOGI("MQTT", "Wifi connected, %s", err == ESP_OK ? "resuming MQTT session" : "MQTT client already reconnecting");
             }
         }
+        return;
+    }
+
+    if (wifiState == WifiManager::Status::Connected && _status.load() == Status::Disconnected) {
+        ESP_LOGI("MQTT", "Wifi connected, starting MQTT client");
+        _clientStarted = esp_mqtt_client_start(_client) == ESP_OK;
+    } else if (wifiState == WifiManager::Status::Disconnected && _status.load() == Status::Connected) {
+        ESP_LOGI("MQTT", "Wifi disconnected, stopping MQTT client");
+        esp_mqtt_client_stop(_client);
+        _clientStarted = false;
+        _status.store(Status::Disconnected);
+        _metrics.onDisconnected(nowMs());
+    }
+}
+
+void MqttManager::drainPublishQueue()
+{
+    _retryPending = false;
+    _livePaced = false;
+    _backlogPaced = false;
+    _outboxPending = false;
+
+    // Offline mode: queues keep their order until MQTT_EVENT_CONNECTED wakes us again,
+    // once the bulk queue fills up its oldest messages go to flash
+    if (_status.load() != Status::Connected) {
+        spillToFlash();
+        return;
+    }
 
-        // Delay task
-        if(!processedQueue) {
-            vTaskDelay(pdMS_TO_TICKS(TASK_LOOP_DELAY_MS));
+    // Bulk waits while the outbox is over budget, the high lane still has its reserve.
+    // Keep polling the outbox so backpressure is released in time
+    bool bulkBlocked = false;
+    if (cfg::kMqttPublishMode == cfg::PublishMode::Enqueue && outboxOverBudget(cfg::kMqttOutboxBudget)) {
+        _outboxPending = true;
+        bulkBlocked = true;
+    }
+
+    // High lane first, but every kHighPriorityBurst high messages one bulk message gets through
+    while (_status.load() == Status::Connected) {
+        const bool highWaiting = _highHead || uxQueueMessagesWaiting(_priorityQueue) > 0;
+        const bool bulkReady = !bulkBlocked && bulkWaiting();
+        const Lane lane = _lanes.next(highWaiting, bulkReady);
+        if (lane == Lane::None) {
+            return;
+        }
+
+        const DrainStep step = lane == Lane::High ? sendHead(_priorityQueue, _highHead, Priority::High) : sendBulk();
+
+        if (step == DrainStep::Blocked) {
+            if (lane == Lane::High) {
+                return;
+            }
+            bulkBlocked = true;
+        } else if (step == DrainStep::Sent) {
+            _lanes.sent(lane);
         }
     }
 }
 
+bool MqttManager::bulkWaiting() const
+{
+    return !_flashLog.empty() || _bulkHead || (_pubQueue && uxQueueMessagesWaiting(_pubQueue) > 0);
+}
+
+MqttManager::DrainStep MqttManager::sendBulk()
+{
+    // Live messages keep their latency after a reconnect, the flash backlog
+    // is replayed in between at a rate the broker and wifi can sustain
+    const uint32_t now = nowMs();
+    if (_bulkHead || (_pubQueue && uxQueueMessagesWaiting(_pubQueue) > 0)) {
+        if (_liveBucket.ready(now)) {
+            const DrainStep step = sendHead(_pubQueue, _bulkHead, Priority::Bulk);
+            if (step == DrainStep::Sent) {
+                _liveBucket.take();
+            }
+            return step;
+        }
+        _livePaced = true;
+    }
+
+    if (!_flashLog.empty()) {
+        if (_backlogBucket.ready(now)) {
+            const DrainStep step = replayOne();
+            if (step == DrainStep::Sent) {
+                _backlogBucket.take();
+            }
+            return step;
+        }
+        _backlogPaced = true;
+    }
+
+    return _livePaced || _backlogPaced ? DrainStep::Blocked : DrainStep::Empty;
+}
+
+MqttManager::DrainStep MqttManager::sendHead(QueueHandle_t queue, PublishSlot& head, Priority priority)
+{
+    // Head leaves the queue but stays ahead of it until the publish succeeded
+    if (!head) {
+        if (xQueueReceive(queue, &head, 0) != pdTRUE) {
+            return DrainStep::Empty;
+        }
+        // From here on no producer may coalesce into this slot
+        if (queue == _pubQueue) {
+            _coalesce.forget(head);
+        }
+    }
+
+    PublishSlot pubMsg = head;
+    int msgId = -1;
+    const SendResult result = sendMessage(*pubMsg, msgId, priority);
+    if (result == SendResult::Retry) {
+        _retryPending = true;
+        return DrainStep::Blocked;
+    }
+    if (result == SendResult::Backpressure) {
+        _outboxPending = true;
+        return DrainStep::Blocked;
+    }
+
+    head = nullptr;
+    if (result == SendResult::Sent) {
+        completeSend(pubMsg, msgId);
+    } else {
+        releaseSlot(pubMsg);
+    }
+    return DrainStep::Sent;
+}
+
+MqttManager::SendResult MqttManager::sendMessage(PublishMessage& msg, int& msgId, Priority priority)
+{
+    msgId = -1;
+
+    // Window full, wait for PUBACKs before sending more QoS>0 messages
+    if (msg.qos > 0 && _inflight.full()) {
+        return SendResult::Backpressure;
+    }
+
+    if constexpr (cfg::kMqttPublishMode == cfg::PublishMode::Enqueue) {
+        // Hand over to the client outbox, the mqtt task does the network I/O.
+        // High messages may use the reserve on top, bulk telemetry cannot hold them back
+        const size_t budget = cfg::kMqttOutboxBudget + (priority == Priority::High ? cfg::kMqttOutboxHighReserve : 0);
+        if (outboxOverBudget(budget)) {
+            return SendResult::Backpressure;
+        }
+    }
+
+    size_t topicLen = 0;
+    msgId = clientPublish(msg, topicLen);
+    if (msgId == OUTBOX_FULL) {
+        return SendResult::Backpressure;
+    }
+
+    if (msgId >= 0) {
+        ESP_LOGD("MQTT", "Published topic %s (%u bytes, sample age %lu ms)", topics::name(msg.topic), msg.payloadLen,
+                 static_cast<unsigned long>(msg.acquiredMs ? nowMs() - msg.acquiredMs : 0));
+        _metrics.countBytes(topicLen + msg.payloadLen);
+        if (msg.enqueuedMs != 0) {
+            _metrics.recordSendLatency(nowMs() - msg.enqueuedMs);
+        }
+        return SendResult::Sent;
+    }
+
+    ESP_LOGE("MQTT", "Failed to publish topic %s (%u bytes)", topics::name(msg.topic), msg.payloadLen);
+    if (msg.retryCount < MAX_RETRY_COUNT) {
+        // Caller keeps the message at the head and retries after a delay
+        msg.retryCount++;
+        _metrics.countRetry();
+        return SendResult::Retry;
+    }
+
+    ESP_LOGE("MQTT", "Retry limit reached for topic %s, dropping.", topics::name(msg.topic));
+    _metrics.countDrop(DropReason::RetryLimit);
+    return SendResult::Dropped;
+}
+
+void MqttManager::completeSend(PublishSlot msg, int msgId)
+{
+    // QoS>0 slots stay owned until the PUBACK arrives
+    if (msg->qos > 0 && msgId > 0 && _inflight.track(msg, msgId, nowMs())) {
+        return;
+    }
+    releaseSlot(msg);
+}
+
+void MqttManager::releaseSlot(PublishSlot msg)
+{
+    if (_priorityPool.owns(msg)) {
+        _priorityPool.release(msg);
+    } else {
+        _pool.release(msg);
+    }
+}
+
+void MqttManager::processAcks()
+{
+    AckEvent ack{};
+    while (xQueueReceive(_ackQueue, &ack, 0) == pdTRUE) {
+        uint32_t firstSentMs = 0;
+        PublishSlot msg = _inflight.ack(ack.msgId, firstSentMs);
+        if (!msg) {
+            ESP_LOGD("MQTT", "PUBACK for untracked msg_id %d", ack.msgId);
+            continue;
+        }
+        _metrics.recordAckLatency(ack.ackMs - firstSentMs);
+        releaseSlot(msg);
+    }
+}
+
+void MqttManager::checkAckTimeouts()
+{
+    if (_status.load() != Status::Connected || _inflight.empty()) {
+        return;
+    }
+
+    const uint32_t now = nowMs();
+    // Messages in flight during an outage get a fresh timeout after reconnect
+    if (_inflightRebase.exchange(false)) {
+        _inflight.rebase(now);
+    }
+
+    // The client resends unacked QoS>0 messages from its outbox with the same msg_id,
+    // a resend of our own would reach the broker as a duplicate. Each timeout counts
+    // as one failed attempt until the message is given up
+    _inflight.forEach([&](auto& entry) {
+        if (now - entry.lastSentMs < cfg::kInflightAckTimeoutMs) {
+            return;
+        }
+
+        if (entry.attempts >= cfg::kInflightMaxAttempts) {
+            ESP_LOGE("MQTT", "No PUBACK for msg_id %d on topic %s, dropping.", entry.msgId, topics::name(entry.item->topic));
+            releaseSlot(_inflight.remove(entry));
+            _metrics.countDrop(DropReason::AckTimeout);
+            return;
+        }
+
+        ESP_LOGW("MQTT", "PUBACK timeout for msg_id %d, attempt %u", entry.msgId, static_cast<unsigned>(entry.attempts));
+        entry.lastSentMs = now;
+        entry.attempts++;
+        _metrics.countRetry();
+    });
+}
+
+int MqttManager::clientPublish(const PublishMessage& msg, size_t& topicLen)
+{
+    topicLen = topics::get(msg.topic).len;
+    auto send = [this, &msg](const char* topic) {
+        return cfg::kMqttPublishMode == cfg::PublishMode::Enqueue
+            ? esp_mqtt_client_enqueue(_client, topic, msg.payload.data(), msg.payloadLen, msg.qos, msg.retain, true)
+            : esp_mqtt_client_publish(_client, topic, msg.payload.data(), msg.payloadLen, msg.qos, msg.retain);
+    };
+
+    if constexpr (!TOPIC_ALIASES) {
+        return send(topics::name(msg.topic));
+    }
+
+#if CONFIG_MQTT_PROTOCOL_5
+    // Aliases are scoped to a connection, the first publish after connect registers them again
+    if (_aliasReset.exchange(false)) {
+        _aliasSent.fill(false);
+        _aliasLimit = cfg::kMqttTopicAliasMax;
+    }
+
+    const size_t idx = static_cast<size_t>(msg.topic);
+    esp_mqtt5_publish_property_config_t property{};
+    const char* topic = topics::name(msg.topic);
+    if (idx < _aliasLimit) {
+        property.topic_alias = static_cast<uint16_t>(idx + 1);
+        // QoS>0 may be resent by the client after a reconnect, so it keeps the full topic
+        if (_aliasSent[idx] && msg.qos == 0) {
+            topic = "";
+            topicLen = 0;
+        }
+    }
+
+    xSemaphoreTake(_clientLock, portMAX_DELAY);
+    if (property.topic_alias && esp_mqtt5_client_set_publish_property(_client, &property) != ESP_OK) {
+        // The client checks the alias against the broker's Topic Alias Maximum from CONNACK,
+        // this and all higher aliases stay unused until the next connection
+        ESP_LOGW("MQTT", "Broker refused topic alias %u, sending full topic", static_cast<unsigned>(property.topic_alias));
+        _aliasLimit = static_cast<uint16_t>(idx);
+        property = {};
+        topic = topics::name(msg.topic);
+        topicLen = topics::get(msg.topic).len;
+    }
+    if (!property.topic_alias) {
+        // Clear the alias of the previous publish
+        esp_mqtt5_client_set_publish_property(_client, &property);
+    }
+    const int msgId = send(topic);
+    xSemaphoreGive(_clientLock);
+
+    if (msgId >= 0 && property.topic_alias) {
+        _aliasSent[idx] = true;
+    }
+    return msgId;
+#endif
+}
+
+bool MqttManager::outboxOverBudget(size_t budget)
+{
+    const int size = esp_mqtt_client_get_outbox_size(_client);
+    _outboxBytes.store(size > 0 ? size : 0);
+    return _outboxBytes.load() >= budget;
+}
+
+/* Flash record layout: qos, retain, topic length, payload length (le16), topic, payload */
+static size_t encodeRecord(const PublishMessage& msg, uint8_t* out, size_t cap)
+{
+    const std::string_view topic = topics::get(msg.topic).view();
+    const size_t topicLen = topic.size();
+    const size_t len = 5 + topicLen + msg.payloadLen;
+    if (len > cap) {
+        return 0;
+    }
+
+    out[0] = static_cast<uint8_t>(msg.qos);
+    out[1] = static_cast<uint8_t>(msg.retain);
+    out[2] = static_cast<uint8_t>(topicLen);
+    out[3] = static_cast<uint8_t>(msg.payloadLen);
+    out[4] = static_cast<uint8_t>(msg.payloadLen >> 8);
+    std::copy(topic.begin(), topic.end(), out + 5);
+    std::copy_n(msg.payload.data(), msg.payloadLen, out + 5 + topicLen);
+    return len;
+}
+
+static bool decodeRecord(const uint8_t* data, size_t len, PublishMessage& msg)
+{
+    if (len < 5) {
+        return false;
+    }
+
+    const size_t topicLen = data[2];
+    const size_t payloadLen = data[3] | (data[4] << 8);
+    if (payloadLen > msg.payload.size() || 5 + topicLen + payloadLen != len) {
+        return false;
+    }
+
+    // Stored by name so the backlog survives reordering of the registry
+    const auto topic = topics::find({reinterpret_cast<const char*>(data + 5), topicLen});
+    if (!topic) {
+        return false;
+    }
+
+    msg.topic = *topic;
+    msg.qos = data[0];
+    msg.retain = data[1];
+    msg.retryCount = 0;
+    msg.acquiredMs = 0;
+    msg.enqueuedMs = 0;
+    std::copy_n(data + 5 + topicLen, payloadLen, msg.payload.begin());
+    if (payloadLen < msg.payload.size()) {
+        msg.payload[payloadLen] = '\0';
+    }
+    msg.payloadLen = static_cast<uint16_t>(payloadLen);
+    return true;
+}
+
+void MqttManager::spillToFlash()
+{
+    if (!_pubQueue || !_flashLog.isValid() || uxQueueMessagesWaiting(_pubQueue) < cfg::kFlashSpillThreshold) {
+        return;
+    }
+
+    // A held head stays in RAM and goes first after reconnect. Coalesced state stays in
+    // the queue as well, flash would keep every snapshot instead of only the latest one
+    size_t stored = 0;
+    PublishSlot msg = nullptr;
+    for (UBaseType_t left = uxQueueMessagesWaiting(_pubQueue); left > 0 && xQueueReceive(_pubQueue, &msg, 0) == pdTRUE; --left) {
+        if (_coalesce.tracks(msg)) {
+            // Pool and queue have the same depth, the slot in hand always fits back
+            if (xQueueSend(_pubQueue, &msg, 0) == pdPASS) {
+                continue;
+            }
+            _coalesce.forget(msg);
+        }
+
+        const size_t len = encodeRecord(*msg, _flashRecord.data(), _flashRecord.size());
+        if (len == 0 || _flashLog.append(_flashRecord.data(), len) != ESP_OK) {
+            ESP_LOGW("MQTT", "Failed to store offline message for topic %s, dropping", topics::name(msg->topic));
+            _metrics.countDrop(DropReason::FlashWrite);
+        } else {
+            stored++;
+        }
+        _pool.release(msg);
+    }
+
+    // The ring overwrites its oldest sector when full, those records are lost as well
+    const uint32_t overwritten = _flashLog.dropped() - _flashDropsCounted;
+    if (overwritten > 0) {
+        ESP_LOGW("MQTT", "Flash backlog full, %lu oldest messages overwritten", static_cast<unsigned long>(overwritten));
+        _metrics.countDrop(DropReason::FlashOverwrite, overwritten);
+        _flashDropsCounted += overwritten;
+    }
+
+    if (stored > 0) {
+        ESP_LOGI("MQTT", "%zu offline messages moved to flash, %zu stored", stored, _flashLog.pending());
+    }
+}
+
+MqttManager::DrainStep MqttManager::replayOne()
+{
+    if (_flashLog.empty()) {
+        return DrainStep::Empty;
+    }
+
+    // Only one record is held in RAM at a time, in a pool slot so QoS>0 can stay in flight
+    if (!_replaySlot) {
+        _replaySlot = _pool.acquire(0);
+        if (!_replaySlot) {
+            _retryPending = true;
+            return DrainStep::Blocked;
+        }
+
+        size_t len = 0;
+        esp_err_t err = _flashLog.peek(_flashRecord.data(), _flashRecord.size(), len);
+        if (err != ESP_OK) {
+            _pool.release(_replaySlot);
+            _replaySlot = nullptr;
+            if (err == ESP_ERR_NOT_FOUND) {
+                return DrainStep::Empty;
+            }
+            ESP_LOGE("MQTT", "Failed to read flash backlog: %s", esp_err_to_name(err));
+            _retryPending = true;
+            return DrainStep::Blocked;
+        }
+        if (!decodeRecord(_flashRecord.data(), len, *_replaySlot)) {
+            ESP_LOGW("MQTT", "Dropping malformed flash record");
+            _pool.release(_replaySlot);
+            _replaySlot = nullptr;
+            _flashLog.pop();
+            return DrainStep::Sent;
+        }
+    }
+
+    int msgId = -1;
+    const SendResult result = sendMessage(*_replaySlot, msgId, Priority::Bulk);
+    if (result == SendResult::Retry) {
+        _retryPending = true;
+        return DrainStep::Blocked;
+    }
+    if (result == SendResult::Backpressure) {
+        _outboxPending = true;
+        return DrainStep::Blocked;
+    }
+
+    _flashLog.pop();
+    if (result == SendResult::Sent) {
+        completeSend(_replaySlot, msgId);
+    } else {
+        _pool.release(_replaySlot);
+    }
+    _replaySlot = nullptr;
+    return DrainStep::Sent;
+}
+
+void MqttManager::collectReadings()
+{
+    // A full batch that cannot be flushed leaves the rest in the reading transport
+    Reading reading{};
+    while ((!_batch.full() || flushBatch()) && nextReading(reading)) {
+        const size_t channel = static_cast<size_t>(reading.channel);
+        if (channel < _deadband.size() && !_deadband[channel].accept(reading.value, reading.timestampMs)) {
+            ESP_LOGD("MQTT", "Reading of channel %u within deadband, suppressed", static_cast<unsigned>(channel));
+            continue;
+        }
+        // Suppressed readings take no number, a gap on the broker is a loss from here on
+        reading.seq = _readingSeq++;
+
+        if (_batch.empty()) {
+            _batchDeadline = xTaskGetTickCount() + pdMS_TO_TICKS(cfg::kBatchWindowMs);
+        }
+        _batch.push(reading);
+    }
+
+    if (!_batch.empty() && (_batch.full() || static_cast<int32_t>(xTaskGetTickCount() - _batchDeadline) >= 0)) {
+        flushBatch();
+    }
+}
+
+bool MqttManager::nextReading(Reading& reading)
+{
+    if constexpr (cfg::kReadingTransport == cfg::ReadingTransport::Ring) {
+        return _readingRing.pop(reading);
+    }
+    return xQueueReceive(_readingQueue, &reading, 0) == pdTRUE;
+}
+
+bool MqttManager::flushBatch()
+{
+    if (!_pubQueue) {
+        ESP_LOGW("MQTT", "No publish queue, dropping %zu batched readings", _batch.size());
+        _batch.clear();
+        return true;
+    }
+
+    // Readings wait in the batch while the outbox is over budget
+    _batchHeld = bulkBackpressure();
+    if (_batchHeld) {
+        return false;
+    }
+
+    // Encode straight into pooled slots, one slot per payload worth of readings
+    const QueueFullPolicy policy = topics::policy(TopicId::SoilBatch);
+    size_t first = 0;
+    while (first < _batch.size()) {
+        PublishSlot msg = acquireSlot(Priority::Bulk, policy);
+        if (!msg) {
+            ESP_LOGW("MQTT", "No free message slot, dropping %zu batched readings", _batch.size() - first);
+            _metrics.countDrop(DropReason::QueueFull);
+            break;
+        }
+
+        size_t len = 0;
+        const size_t written = payload::encode(
+            cfg::kPayloadFormat,
+            _batch.data() + first,
+            _batch.size() - first,
+            _batchSeq,
+            msg->payload.data(),
+            msg->payload.size(),
+            len
+        );
+        if (written == 0) {
+            ESP_LOGE("MQTT", "Failed to encode batch, dropping %zu readings", _batch.size() - first);
+            _pool.release(msg);
+            _metrics.countDrop(DropReason::Encode);
+            break;
+        }
+
+        msg->topic = TopicId::SoilBatch;
+        msg->payloadLen = static_cast<uint16_t>(len);
+        msg->qos = 0;
+        msg->retain = 0;
+        msg->retryCount = 0;
+        msg->acquiredMs = _batch[first].timestampMs;
+        msg->enqueuedMs = nowMs();
+        _metrics.recordSampleAge(msg->enqueuedMs - msg->acquiredMs);
+
+        if (submit(msg, Priority::Bulk, policy) != ESP_OK) {
+            ESP_LOGW("MQTT", "Publish queue full, dropping %zu batched readings", _batch.size() - first);
+            break;
+        }
+        _batchSeq++;
+        first += written;
+    }
+
+    _batch.clear();
+    return true;
+}
+
+void MqttManager::publishMetrics()
+{
+    if (static_cast<int32_t>(xTaskGetTickCount() - _metricsDeadline) < 0) {
+        return;
+    }
+    _metricsDeadline = xTaskGetTickCount() + pdMS_TO_TICKS(cfg::kMetricsIntervalMs);
+
+    char buf[sizeof(PublishMessage::payload)];
+    size_t len = 0;
+    if (!payload::encodeMetrics(cfg::kPayloadFormat, _metrics.snapshot(nowMs()), buf, sizeof(buf), len)) {
+        ESP_LOGW("MQTT", "Failed to encode metrics");
+        return;
+    }
+    // Only the latest snapshot matters if the previous one is still queued
+    enqueue(TopicId::Diagnostics, {buf, len}, 0, Priority::Bulk, QueueFullPolicy::Coalesce);
+}
+
+TickType_t MqttManager::nextWaitTicks() const
+{
+    TickType_t waitTicks = _retryPending ? pdMS_TO_TICKS(RETRY_DELAY_MS) : portMAX_DELAY;
+
+    if (_outboxPending) {
+        waitTicks = std::min<TickType_t>(waitTicks, pdMS_TO_TICKS(OUTBOX_POLL_MS));
+    }
+
+    if (_status.load() == Status::Connected) {
+        if (const auto* entry = _inflight.oldest()) {
+            const int32_t untilTimeout = static_cast<int32_t>(entry->lastSentMs + cfg::kInflightAckTimeoutMs - nowMs());
+            waitTicks = std::min<TickType_t>(waitTicks, untilTimeout > 0 ? ticksFromMs(untilTimeout) : 0);
+        }
+    }
+
+    if (_livePaced) {
+        waitTicks = std::min<TickType_t>(waitTicks, ticksFromMs(_liveBucket.msUntilReady(nowMs())));
+    }
+
+    if (_backlogPaced) {
+        waitTicks = std::min<TickType_t>(waitTicks, ticksFromMs(_backlogBucket.msUntilReady(nowMs())));
+    }
+
+    const int32_t untilMetrics = static_cast<int32_t>(_metricsDeadline - xTaskGetTickCount());
+    waitTicks = std::min<TickType_t>(waitTicks, untilMetrics > 0 ? untilMetrics : 0);
+
+    if (!_batch.empty() && !_batchHeld) {
+        const int32_t untilFlush = static_cast<int32_t>(_batchDeadline - xTaskGetTickCount());
+        waitTicks = std::min<TickType_t>(waitTicks, untilFlush > 0 ? untilFlush : 0);
+    }
+
+    return waitTicks;
+}
+
+void MqttManager::wake()
+{
+    if (_wakeSignal) {
+        xSemaphoreGive(_wakeSignal);
+    }
+}
+
 void MqttManager::eventHandler(void *event_handler_arg, esp_event_base_t event_base, int32_t event_id, void *event_data)
 {
     auto *self = static_cast<MqttManager*>(event_handler_arg);
 
     switch (event_id) {
-        case MQTT_EVENT_CONNECTED:
+        case MQTT_EVENT_CONNECTED: {
+            const auto* event = static_cast<esp_mqtt_event_handle_t>(event_data);
+            if (cfg::kMqttPersistentSession && !event->session_present) {
+                ESP_LOGW("MQTT", "Broker has no session for this client, starting a new one");
+            }
+            // Reset per connection state before the manager task can see Connected,
+            // an alias only publish with the old aliases is a protocol error on the new link
+            self->_inflightRebase.store(true);
+            self->_aliasReset.store(true);
             self->_status.store(Status::Connected);
+            self->_metrics.onConnected(nowMs());
+            if (self->_commandQueue) {
+                // Also after a resumed session, the broker may have dropped the subscription
+                esp_mqtt_client_subscribe(self->_client, topics::kCalibrate.c_str(), 1);
+            }
             self->_eg.set(CONNECTED_BIT);
+            self->wake();
             ESP_LOGI("MQTT", "Connected to broker");
             break;
+        }
         case MQTT_EVENT_DISCONNECTED:
             self->_status.store(Status::Disconnected);
+            self->_metrics.onDisconnected(nowMs());
             self->_eg.set(DISCONNECTED_BIT);
+            self->wake();
             ESP_LOGW("MQTT", "Disconnected from broker");
             break;
+        case MQTT_EVENT_PUBLISHED: {
+            // PUBACK, correlated with the in-flight window by the manager task
+            const auto* event = static_cast<esp_mqtt_event_handle_t>(event_data);
+            const AckEvent ack{event->msg_id, nowMs()};
+            if (xQueueSend(self->_ackQueue, &ack, 0) != pdPASS) {
+                ESP_LOGW("MQTT", "Ack queue full, PUBACK for msg_id %d lost", ack.msgId);
+            }
+            self->wake();
+            break;
+        }
+        case MQTT_EVENT_DATA:
+            self->handleCommand(*static_cast<esp_mqtt_event_handle_t>(event_data));
+            break;
         case MQTT_EVENT_ERROR:
             ESP_LOGE("MQTT", "MQTT Error occurred");
             break;
     }
 }
 
-esp_err_t MqttManager::publish(const char* topic, const char* payload, int qos) const
+void MqttManager::handleCommand(const esp_mqtt_event_t& event)
+{
+    // Commands are a few bytes, a fragmented message is not one of ours
+    if (!_commandQueue || event.current_data_offset != 0 || event.data_len != event.total_data_len) {
+        return;
+    }
+    if (!event.topic || std::string_view{event.topic, static_cast<size_t>(event.topic_len)} != topics::kCalibrate.view()) {
+        return;
+    }
+    // A retained command would capture again on every boot and reconnect
+    if (event.retain) {
+        ESP_LOGW("MQTT", "Ignoring retained calibration command, clear it on the broker");
+        return;
+    }
+
+    const std::string_view payload{event.data, static_cast<size_t>(event.data_len)};
+    const auto command = parseCalibrationCommand(payload);
+    if (!command) {
+        ESP_LOGW("MQTT", "Unknown calibration command: %.*s", static_cast<int>(payload.size()), payload.data());
+        return;
+    }
+    if (xQueueSend(_commandQueue, &*command, 0) != pdPASS) {
+        ESP_LOGW("MQTT", "Command queue full, calibration command dropped");
+    }
+}
+
+esp_err_t MqttManager::publish(TopicId topic, std::string_view payload, int qos) const
 {
     if (_status.load() != Status::Connected) {
         return ESP_ERR_INVALID_STATE;
     }
     
-    return esp_mqtt_client_publish(_client, topic, payload, 0, qos, 0);
+    if constexpr (!TOPIC_ALIASES) {
+        return esp_mqtt_client_publish(_client, topics::name(topic), payload.data(), payload.size(), qos, 0);
+    }
+
+#if CONFIG_MQTT_PROTOCOL_5
+    // Direct publishes always carry the full topic without an alias
+    const esp_mqtt5_publish_property_config_t property{};
+    xSemaphoreTake(_clientLock, portMAX_DELAY);
+    esp_mqtt5_client_set_publish_property(_client, &property);
+    const int msgId = esp_mqtt_client_publish(_client, topics::name(topic), payload.data(), payload.size(), qos, 0);
+    xSemaphoreGive(_clientLock);
+    return msgId;
+#endif
+}
+
+esp_err_t MqttManager::queuePublish(TopicId topic, std::string_view payload, int qos)
+{
+    return enqueue(topic, payload, qos, Priority::Bulk, topics::policy(topic));
+}
+
+esp_err_t MqttManager::queuePublish(TopicId topic, std::string_view payload, int qos, Priority priority)
+{
+    return enqueue(topic, payload, qos, priority, topics::policy(topic));
 }
 
-esp_err_t MqttManager::queuePublish(const char* topic, const char* payload, int qos) const
+esp_err_t MqttManager::queuePublish(TopicId topic, std::string_view payload, int qos, Priority priority, QueueFullPolicy policy)
 {
-    if (!_pubQueue || !topic || !payload) {
+    return enqueue(topic, payload, qos, priority, policy);
+}
+
+esp_err_t MqttManager::queueState(TopicId topic, std::string_view payload, int qos)
+{
+    return enqueue(topic, payload, qos, Priority::Bulk, QueueFullPolicy::Coalesce);
+}
+
+esp_err_t MqttManager::enqueue(TopicId topic, std::string_view payload, int qos, Priority priority, QueueFullPolicy policy)
+{
+    const bool high = priority == Priority::High;
+    QueueHandle_t queue = high ? _priorityQueue : _pubQueue;
+
+    if (!queue) {
         return ESP_ERR_INVALID_ARG;
     }
+
+    // Backpressure: fail fast instead of piling up behind a saturated outbox
+    if (!high && bulkBackpressure()) {
+        _metrics.countDrop(DropReason::OutboxBudget);
+        return ESP_ERR_NO_MEM;
+    }
     
-    if (strlen(topic) >= sizeof(PublishMessage::topic) || 
-        strlen(payload) >= sizeof(PublishMessage::payload)) {
-        ESP_LOGW("MQTT", "Message too large - topic: %zu, payload: %zu", 
-                 strlen(topic), strlen(payload));
+    // Topic length is checked at compile time by the registry
+    if (payload.size() >= sizeof(PublishMessage::payload)) {
+        ESP_LOGW("MQTT", "Payload too large for topic %s: %zu", topics::name(topic), payload.size());
         return ESP_ERR_INVALID_SIZE;
     }
 
-    PublishMessage msg{};
-    std::copy_n(topic, std::min(strlen(topic), msg.topic.size() - 1), msg.topic.begin());
-    msg.topic[std::min(strlen(topic), msg.topic.size() - 1)] = '\0';
+    // Latest value wins: pending state is updated in place, offline memory stays bounded per topic
+    const bool coalesce = !high && policy == QueueFullPolicy::Coalesce;
+    if (coalesce && _coalesce.replace(topic, payload, qos, nowMs())) {
+        _metrics.countDrop(DropReason::Coalesced);
+        return ESP_OK;
+    }
+
+    // Fill pooled slot in place, the queue only carries the pointer
+    PublishSlot msg = acquireSlot(priority, policy);
+    if (!msg) {
+        ESP_LOGD("MQTT", "No free message slot, dropping message for topic %s", topics::name(topic));
+        _metrics.countDrop(DropReason::QueueFull);
+        return ESP_ERR_NO_MEM;
+    }
 
-    std::copy_n(payload, std::min(strlen(payload), msg.payload.size() - 1), msg.payload.begin());
-    msg.payload[std::min(strlen(payload), msg.payload.size() - 1)] = '\0';
+    msg->topic = topic;
+    std::copy(payload.begin(), payload.end(), msg->payload.begin());
+    msg->payload[payload.size()] = '\0';
+    msg->payloadLen = static_cast<uint16_t>(payload.size());
 
-    msg.qos = qos;
-    msg.retain = 0;
-    msg.retryCount = 0;
+    msg->qos = qos;
+    msg->retain = 0;
+    msg->retryCount = 0;
+    msg->acquiredMs = 0;
+    msg->enqueuedMs = nowMs();
+
+    if (coalesce) {
+        _coalesce.track(msg);
+    }
+
+    return submit(msg, priority, policy);
+}
+
+esp_err_t MqttManager::submit(PublishSlot msg, Priority priority, QueueFullPolicy policy)
+{
+    const bool high = priority == Priority::High;
+    QueueHandle_t queue = high ? _priorityQueue : _pubQueue;
+
+    // Queue and pool have the same depth, a slot in hand normally means space in the queue
+    const TickType_t timeout = policy == QueueFullPolicy::Block ? pdMS_TO_TICKS(QUEUE_SEND_TIMEOUT_MS) : 0;
+    if (xQueueSend(queue, &msg, timeout) != pdPASS) {
+        ESP_LOGD("MQTT", "Publish queue full, dropping message for topic %s", topics::name(msg->topic));
+        if (!high && policy == QueueFullPolicy::Coalesce) {
+            _coalesce.forget(msg);
+        }
+        releaseSlot(msg);
+        _metrics.countDrop(DropReason::QueueFull);
+        return ESP_ERR_TIMEOUT;
+    }
+    if (!high) {
+        _metrics.noteQueueDepth(uxQueueMessagesWaiting(queue));
+    }
+
+    wake();
+    return ESP_OK;
+}
+
+bool MqttManager::bulkBackpressure() const
+{
+    // Offline messages are still accepted for store and forward
+    return cfg::kMqttPublishMode == cfg::PublishMode::Enqueue && _status.load() == Status::Connected
+        && _outboxBytes.load() >= cfg::kMqttOutboxBudget;
+}
+
+PublishSlot MqttManager::acquireSlot(Priority priority, QueueFullPolicy policy)
+{
+    // High priority has its own pool so a bulk backlog can never starve it of slots
+    const bool high = priority == Priority::High;
+    const TickType_t timeout = policy == QueueFullPolicy::Block ? pdMS_TO_TICKS(QUEUE_SEND_TIMEOUT_MS) : 0;
+    PublishSlot msg = high ? _priorityPool.acquire(timeout) : _pool.acquire(timeout);
+    if (msg || policy != QueueFullPolicy::DropOldest) {
+        return msg;
+    }
+
+    // Reuse the slot of the oldest queued message, the manager only sends what it already took out
+    QueueHandle_t queue = high ? _priorityQueue : _pubQueue;
+    if (xQueueReceive(queue, &msg, 0) != pdTRUE) {
+        return nullptr;
+    }
+    if (!high) {
+        _coalesce.forget(msg);
+    }
+    ESP_LOGD("MQTT", "Publish queue full, evicted oldest message for topic %s", topics::name(msg->topic));
+    _metrics.countDrop(DropReason::Evicted);
+    return msg;
+}
+
+esp_err_t MqttManager::queueReading(ReadingChannel channel, int32_t value)
+{
+    return queueReading(channel, value, stampSample());
+}
+
+esp_err_t MqttManager::queueReading(ReadingChannel channel, int32_t value, const SampleStamp& stamp)
+{
+    const bool useRing = cfg::kReadingTransport == cfg::ReadingTransport::Ring;
+    if (!useRing && !_readingQueue) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Numbered by the manager task once it passes the deadband
+    Reading reading{
+        stamp.acquiredMs,
+        0,
+        channel,
+        value
+    };
 
-    if (xQueueSend(_pubQueue, &msg, pdMS_TO_TICKS(QUEUE_SEND_TIMEOUT_MS)) != pdPASS) {
-        ESP_LOGW("MQTT", "Failed to queue publish message for topic %s", msg.topic.data());
+    // The ring skips the queue's critical section, the wake signal still wakes the manager
+    const bool queued = useRing ? _readingRing.push(reading) : xQueueSend(_readingQueue, &reading, 0) == pdPASS;
+    if (!queued) {
+        ESP_LOGW("MQTT", "Reading queue full, dropping reading of channel %u", static_cast<unsigned>(channel));
+        _metrics.countDrop(DropReason::ReadingQueue);
         return ESP_ERR_TIMEOUT;
     }
 
+    wake();
     return ESP_OK;
 }
\ No newline at end of file
@@ -0,0 +1,228 @@
+#include "payload_encoder.hpp"
+#include "cbor_writer.hpp"
+#include <algorithm>
+#include <cstdio>
+
+namespace payload
+{
+
+size_t encode(PayloadFormat format, const Reading* readings, size_t count, uint32_t seq,
+              char* out, size_t cap, size_t& len)
+{
+    if (format == PayloadFormat::Cbor) {
+        return encodeCbor(readings, count, seq, reinterpret_cast<uint8_t*>(out), cap, len);
+    }
+    return encodeText(readings, count, seq, out, cap, len);
+}
+
+size_t encodeText(const Reading* readings, size_t count, uint32_t seq, char* out, size_t cap, size_t& len)
+{
+    len = 0;
+    if (!readings || !out || count == 0) {
+        return 0;
+    }
+
+    const uint32_t t0 = readings[0].timestampMs;
+    const uint32_t q0 = readings[0].seq;
+    int n = snprintf(out, cap, "{\"s\":%lu,\"t\":%lu,\"q\":%lu,\"u\":[",
+                     static_cast<unsigned long>(seq), static_cast<unsigned long>(t0), static_cast<unsigned long>(q0));
+    if (n < 0 || static_cast<size_t>(n) >= cap) {
+        return 0;
+    }
+    len = n;
+
+    for (size_t i = 0; i < kChannelUnits.size(); ++i) {
+        n = snprintf(out + len, cap - len, "%s\"%.*s\"", i ? "," : "",
+                     static_cast<int>(kChannelUnits[i].size()), kChannelUnits[i].data());
+        if (n < 0 || len + n >= cap) {
+            len = 0;
+            return 0;
+        }
+        len += n;
+    }
+
+    n = snprintf(out + len, cap - len, "],\"r\":[");
+    if (n < 0 || len + n >= cap) {
+        len = 0;
+        return 0;
+    }
+    len += n;
+
+    // Closing "]}" and terminator have to fit after the last entry
+    static constexpr size_t TAIL = 3;
+    char entry[56];
+    size_t written = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        const Reading& r = readings[i];
+        n = snprintf(entry, sizeof(entry), "%s[%lu,%u,%ld,%lu]",
+                     written ? "," : "",
+                     static_cast<unsigned long>(r.timestampMs - t0),
+                     static_cast<unsigned>(r.channel),
+                     static_cast<long>(r.value),
+                     static_cast<unsigned long>(r.seq - q0));
+        if (n < 0 || len + n + TAIL > cap) {
+            break;
+        }
+        std::copy_n(entry, n, out + len);
+        len += n;
+        ++written;
+    }
+
+    if (written == 0) {
+        len = 0;
+        return 0;
+    }
+
+    out[len++] = ']';
+    out[len++] = '}';
+    out[len] = '\0';
+    return written;
+}
+
+size_t encodeCbor(const Reading* readings, size_t count, uint32_t seq, uint8_t* out, size_t cap, size_t& len)
+{
+    len = 0;
+    if (!readings || !out || count == 0) {
+        return 0;
+    }
+
+    const uint32_t t0 = readings[0].timestampMs;
+    const uint32_t q0 = readings[0].seq;
+    CborWriter writer{out, cap};
+
+    writer.beginMap(5);
+    writer.writeText("s");
+    writer.writeUint(seq);
+    writer.writeText("t");
+    writer.writeUint(t0);
+    writer.writeText("q");
+    writer.writeUint(q0);
+    writer.writeText("u");
+    writer.beginArray(kChannelUnits.size());
+    for (const auto& unit : kChannelUnits) {
+        writer.writeText(unit);
+    }
+    writer.writeText("r");
+    writer.beginIndefiniteArray();
+
+    size_t written = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const Reading& r = readings[i];
+        const uint32_t dt = r.timestampMs - t0;
+        const uint32_t dq = r.seq - q0;
+        // array head + dt + channel + value + dq, plus the closing break byte
+        const size_t entrySize = 1 + CborWriter::headSize(dt) + CborWriter::headSize(static_cast<uint8_t>(r.channel))
+                               + CborWriter::intSize(r.value) + CborWriter::headSize(dq);
+        if (!writer.ok() || entrySize + 1 > writer.remaining()) {
+            break;
+        }
+        writer.beginArray(4);
+        writer.writeUint(dt);
+        writer.writeUint(static_cast<uint8_t>(r.channel));
+        writer.writeInt(r.value);
+        writer.writeUint(dq);
+        ++written;
+    }
+
+    writer.endIndefinite();
+
+    if (written == 0 || !writer.ok()) {
+        return 0;
+    }
+
+    len = writer.size();
+    return written;
+}
+
+static bool encodeMetricsText(const MetricsSnapshot& m, char* out, size_t cap, size_t& len)
+{
+    len = 0;
+    int n = snprintf(out, cap, "{\"la\":[%lu,%lu,%lu],\"lq\":[%lu,%lu,%lu],\"lk\":[%lu,%lu],\"hw\":%lu,\"rt\":%lu,\"dr\":[",
+                     static_cast<unsigned long>(m.sampleAgeMs[0]), static_cast<unsigned long>(m.sampleAgeMs[1]),
+                     static_cast<unsigned long>(m.sampleAgeMs[2]), static_cast<unsigned long>(m.sendLatencyMs[0]), static_cast<unsigned long>(m.sendLatencyMs[1]),
+                     static_cast<unsigned long>(m.sendLatencyMs[2]), static_cast<unsigned long>(m.ackLatencyMs[0]),
+                     static_cast<unsigned long>(m.ackLatencyMs[1]), static_cast<unsigned long>(m.queueHighWater),
+                     static_cast<unsigned long>(m.retries));
+    if (n < 0 || static_cast<size_t>(n) >= cap) {
+        return false;
+    }
+    len = n;
+
+    for (size_t i = 0; i < m.drops.size(); ++i) {
+        n = snprintf(out + len, cap - len, "%s%lu", i ? "," : "", static_cast<unsigned long>(m.drops[i]));
+        if (n < 0 || len + n >= cap) {
+            len = 0;
+            return false;
+        }
+        len += n;
+    }
+
+    n = snprintf(out + len, cap - len, "],\"tx\":%lu,\"rc\":%lu,\"up\":%lu}",
+                 static_cast<unsigned long>(m.bytesSent), static_cast<unsigned long>(m.reconnects),
+                 static_cast<unsigned long>(m.connectedS));
+    if (n < 0 || len + n >= cap) {
+        len = 0;
+        return false;
+    }
+    len += n;
+    return true;
+}
+
+static bool encodeMetricsCbor(const MetricsSnapshot& m, uint8_t* out, size_t cap, size_t& len)
+{
+    len = 0;
+    CborWriter writer{out, cap};
+
+    writer.beginMap(9);
+    writer.writeText("la");
+    writer.beginArray(m.sampleAgeMs.size());
+    for (uint32_t ms : m.sampleAgeMs) {
+        writer.writeUint(ms);
+    }
+    writer.writeText("lq");
+    writer.beginArray(m.sendLatencyMs.size());
+    for (uint32_t ms : m.sendLatencyMs) {
+        writer.writeUint(ms);
+    }
+    writer.writeText("lk");
+    writer.beginArray(m.ackLatencyMs.size());
+    for (uint32_t ms : m.ackLatencyMs) {
+        writer.writeUint(ms);
+    }
+    writer.writeText("hw");
+    writer.writeUint(m.queueHighWater);
+    writer.writeText("rt");
+    writer.writeUint(m.retries);
+    writer.writeText("dr");
+    writer.beginArray(m.drops.size());
+    for (uint32_t drops : m.drops) {
+        writer.writeUint(drops);
+    }
+    writer.writeText("tx");
+    writer.writeUint(m.bytesSent);
+    writer.writeText("rc");
+    writer.writeUint(m.reconnects);
+    writer.writeText("up");
+    writer.writeUint(m.connectedS);
+
+    if (!writer.ok()) {
+        return false;
+    }
+    len = writer.size();
+    return true;
+}
+
+bool encodeMetrics(PayloadFormat format, const MetricsSnapshot& metrics, char* out, size_t cap, size_t& len)
+{
+    if (!out) {
+        len = 0;
+        return false;
+    }
+    if (format == PayloadFormat::Cbor) {
+        return encodeMetricsCbor(metrics, reinterpret_cast<uint8_t*>(out), cap, len);
+    }
+    return encodeMetricsText(metrics, out, cap, len);
+}
+
+} // namespace payload
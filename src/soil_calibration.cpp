@@ -0,0 +1,52 @@
+#include "soil_calibration.hpp"
+#include "nvs.h"
+#include "esp_log.h"
+
+std::optional<SoilCalibration> CalibrationStore::load() const
+{
+    nvs_handle_t handle{};
+    esp_err_t ret = nvs_open(_namespace, NVS_READONLY, &handle);
+    if (ret != ESP_OK) {
+        // Namespace does not exist before the first save
+        return std::nullopt;
+    }
+
+    Record record{};
+    size_t len = sizeof(record);
+    ret = nvs_get_blob(handle, KEY, &record, &len);
+    nvs_close(handle);
+
+    if (ret != ESP_OK || len != sizeof(record) || record.version != RECORD_VERSION) {
+        return std::nullopt;
+    }
+    if (!record.calibration.isValid()) {
+        ESP_LOGW("SOIL", "Stored calibration is not valid, ignoring it");
+        return std::nullopt;
+    }
+    return record.calibration;
+}
+
+esp_err_t CalibrationStore::save(const SoilCalibration& calibration) const
+{
+    nvs_handle_t handle{};
+    esp_err_t ret = nvs_open(_namespace, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE("SOIL", "Failed to open calibration storage: %d", ret);
+        return ret;
+    }
+
+    // Stored as raw bytes, padding must not carry stack contents into NVS
+    Record record{};
+    record.version = RECORD_VERSION;
+    record.calibration = calibration;
+    ret = nvs_set_blob(handle, KEY, &record, sizeof(record));
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    if (ret != ESP_OK) {
+        ESP_LOGE("SOIL", "Failed to store calibration: %d", ret);
+    }
+    return ret;
+}
@@ -4,6 +4,8 @@
 SoilMoistureSensor::SoilMoistureSensor() {
     _initialized = initAdc();
     if (_initialized) {
+        initCalibration();
+        loadCalibration();
         ESP_LOGI("SOIL", "Soil moisture sensor initialized successfully");
     } else {
         ESP_LOGE("SOIL", "Failed to initialize soil moisture sensor");
@@ -11,12 +13,22 @@ SoilMoistureSensor::SoilMoistureSensor() {
 }
 
 SoilMoistureSensor::~SoilMoistureSensor() {
-    if (_initialized) {
+    if (!_initialized) {
+        return;
+    }
+    if (_dmaHandle) {
+        // Stopped after every frame, see readFrame()
+        adc_continuous_deinit(_dmaHandle);
+    } else {
         adc_oneshot_del_unit(_adcHandle);
     }
 }
 
 bool SoilMoistureSensor::initAdc() {
+    if constexpr (cfg::kAdcBackend == cfg::AdcBackend::Continuous) {
+        return initContinuous();
+    }
+
     // ADC init configuration
     adc_oneshot_unit_init_cfg_t initConfig{};
     initConfig.unit_id = ADC_UNIT;
@@ -46,38 +58,232 @@ bool SoilMoistureSensor::initAdc() {
     return true;
 }
 
-int SoilMoistureSensor::readRawValue() {
-    if (!_initialized) {
-        return -1;
+bool SoilMoistureSensor::initContinuous() {
+    adc_continuous_handle_cfg_t handleConfig{};
+    handleConfig.max_store_buf_size = FRAME_STORE_BYTES;
+    handleConfig.conv_frame_size = cfg::kAdcFrameBytes;
+
+    esp_err_t ret = adc_continuous_new_handle(&handleConfig, &_dmaHandle);
+    if (ret != ESP_OK) {
+        ESP_LOGE("SOIL", "Failed to create continuous ADC: %d", ret);
+        _dmaHandle = nullptr;
+        return false;
     }
-    
-    int rawValue = 0;
-    esp_err_t ret = adc_oneshot_read(_adcHandle, ADC_CHANNEL, &rawValue);
+
+    // Single channel pattern, the DMA fills whole frames without CPU involvement
+    adc_digi_pattern_config_t pattern{};
+    pattern.atten = ADC_ATTEN;
+    pattern.channel = ADC_CHANNEL;
+    pattern.unit = ADC_UNIT;
+    pattern.bit_width = ADC_WIDTH;
+
+    adc_continuous_config_t digiConfig{};
+    digiConfig.pattern_num = 1;
+    digiConfig.adc_pattern = &pattern;
+    digiConfig.sample_freq_hz = cfg::kAdcSampleRateHz;
+    digiConfig.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    digiConfig.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+
+    // Started per acquisition, see readFrame()
+    ret = adc_continuous_config(_dmaHandle, &digiConfig);
     if (ret != ESP_OK) {
-        ESP_LOGE("SOIL", "ADC read error: %d", ret);
-        return -1;
+        ESP_LOGE("SOIL", "Failed to configure continuous ADC: %d", ret);
+        adc_continuous_deinit(_dmaHandle);
+        _dmaHandle = nullptr;
+        return false;
     }
-    
-    return rawValue;
+
+    return true;
+}
+
+void SoilMoistureSensor::initCalibration() {
+    // Line fitting uses the eFuse reference, without it millivolts stay unknown
+    adc_cali_line_fitting_config_t caliConfig{};
+    caliConfig.unit_id = ADC_UNIT;
+    caliConfig.atten = ADC_ATTEN;
+    caliConfig.bitwidth = ADC_WIDTH;
+
+    // The scheme is only needed to sample the table, samples never call into it
+    adc_cali_handle_t caliHandle{};
+    esp_err_t ret = adc_cali_create_scheme_line_fitting(&caliConfig, &caliHandle);
+    if (ret == ESP_OK) {
+        _calibrated = _mvLut.build([caliHandle](int raw, int& mv) {
+            return adc_cali_raw_to_voltage(caliHandle, raw, &mv) == ESP_OK;
+        });
+        adc_cali_delete_scheme_line_fitting(caliHandle);
+    } else {
+        ESP_LOGW("SOIL", "ADC calibration not available: %d", ret);
+    }
+
+    if (!_calibrated) {
+        // Nominal straight line, keeps percent in the same mV space as the dry/wet points
+        _mvLut.build([](int raw, int& mv) {
+            mv = raw * NOMINAL_FULL_SCALE_MV / MvLut::MAX_RAW;
+            return true;
+        });
+    }
+}
+
+void SoilMoistureSensor::loadCalibration() {
+    if (const auto stored = _calibrationStore.load()) {
+        _calibration = *stored;
+        ESP_LOGI("SOIL", "Calibration loaded: dry %ld mV, wet %ld mV",
+                 static_cast<long>(_calibration.airMv), static_cast<long>(_calibration.waterMv));
+    } else {
+        ESP_LOGW("SOIL", "No stored calibration, using defaults");
+    }
+}
+
+FrameStats SoilMoistureSensor::readFrame() {
+    // The converter only runs for one frame per acquisition, between samples it costs
+    // no interrupts. Frames converted before the last stop are stale by now
+    adc_continuous_flush_pool(_dmaHandle);
+    esp_err_t ret = adc_continuous_start(_dmaHandle);
+    if (ret != ESP_OK) {
+        ESP_LOGE("SOIL", "Failed to start continuous ADC: %d", ret);
+        return {};
+    }
+
+    uint32_t len = 0;
+    ret = adc_continuous_read(_dmaHandle, _frame.data(), _frame.size(), &len, cfg::kAdcFrameTimeoutMs);
+    adc_continuous_stop(_dmaHandle);
+    if (ret != ESP_OK) {
+        ESP_LOGE("SOIL", "ADC frame read error: %d", ret);
+        return {};
+    }
+
+    FrameStats stats{};
+    adc_frame::forEachType1(_frame.data(), len, static_cast<uint8_t>(ADC_CHANNEL), [this, &stats](uint16_t data) {
+        adc_frame::accumulate(stats, data);
+        _filter.push(data);
+    });
+    if (stats.count == 0) {
+        ESP_LOGE("SOIL", "ADC frame without samples of channel %d", static_cast<int>(ADC_CHANNEL));
+    }
+    return stats;
+}
+
+FrameStats SoilMoistureSensor::readBurst() {
+    FrameStats stats{};
+    for (size_t i = 0; i < cfg::kAdcSamplesPerRead; ++i) {
+        int rawValue = 0;
+        esp_err_t ret = adc_oneshot_read(_adcHandle, ADC_CHANNEL, &rawValue);
+        if (ret != ESP_OK) {
+            ESP_LOGE("SOIL", "ADC read error: %d", ret);
+            // A partial burst would shift the decimation phase
+            _filter.reset();
+            return {};
+        }
+        adc_frame::accumulate(stats, static_cast<uint16_t>(rawValue));
+        _filter.push(rawValue);
+    }
+    return stats;
+}
+
+FrameStats SoilMoistureSensor::acquire() {
+    if (!_initialized) {
+        return {};
+    }
+
+    if constexpr (cfg::kAdcBackend == cfg::AdcBackend::Continuous) {
+        return readFrame();
+    }
+    return readBurst();
+}
+
+SoilSample SoilMoistureSensor::sample() {
+    const FrameStats stats = acquire();
+
+    SoilSample result{-1, -1, -1, stampSample(), SampleQuality::Invalid};
+    if (stats.count == 0) {
+        return result;
+    }
+
+    // Filter output carries history across acquisitions, the plain average is the fallback
+    const int32_t fixed = _filter.hasOutput() ? _filter.fixed() : filter::toFixed(stats.average());
+    result.raw = filter::fromFixed(fixed);
+    // Fraction bits of the filter output survive into the millivolts
+    const int mv = _mvLut.toMillivolts(fixed, filter::FRAC_BITS);
+    result.millivolts = _calibrated ? mv : -1;
+
+    // Map millivolts to moisture percentage (0-100%)
+    // Constrain values to the calibration range
+    const int airMv = _calibration.airMv;
+    const int waterMv = _calibration.waterMv;
+    const int clamped = std::max(std::min(mv, airMv), waterMv);
+    result.percent = map(clamped, airMv, waterMv, 0, 100);
+
+    if (clamped != mv) {
+        result.quality = SampleQuality::Clipped;
+    } else if (stats.spread() > NOISY_SPREAD) {
+        result.quality = SampleQuality::Noisy;
+    } else if (!_calibrated) {
+        result.quality = SampleQuality::Uncalibrated;
+    } else {
+        result.quality = SampleQuality::Good;
+    }
+
+    return result;
+}
+
+int SoilMoistureSensor::readRawValue() {
+    return sample().raw;
 }
 
 int SoilMoistureSensor::readMoisturePercent() {
-    int rawValue = readRawValue();
-    if (rawValue < 0) {
+    return sample().percent;
+}
+
+esp_err_t SoilMoistureSensor::calibrate(CalibrationCommand command) {
+    SoilCalibration updated = _calibration;
+
+    if (command == CalibrationCommand::Reset) {
+        updated = DEFAULT_CALIBRATION;
+    } else {
+        const int mv = captureMillivolts();
+        if (mv < 0) {
+            ESP_LOGE("SOIL", "Calibration capture failed");
+            return ESP_FAIL;
+        }
+        (command == CalibrationCommand::CaptureDry ? updated.airMv : updated.waterMv) = mv;
+        ESP_LOGI("SOIL", "Captured %s point: %d mV", command == CalibrationCommand::CaptureDry ? "dry" : "wet", mv);
+    }
+
+    // A point on the wrong side of the other one would invert the mapping
+    if (!updated.isValid()) {
+        ESP_LOGW("SOIL", "Rejected calibration: dry %ld mV, wet %ld mV",
+                 static_cast<long>(updated.airMv), static_cast<long>(updated.waterMv));
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const esp_err_t ret = _calibrationStore.save(updated);
+    if (ret == ESP_OK) {
+        _calibration = updated;
+    }
+    return ret;
+}
+
+int SoilMoistureSensor::captureMillivolts() {
+    // Plain averages, the filter history still holds the medium the probe came from
+    uint32_t sum = 0;
+    size_t count = 0;
+    for (size_t i = 0; i < cfg::kCalibrationSamples; ++i) {
+        const FrameStats stats = acquire();
+        if (stats.count == 0) {
+            continue;
+        }
+        sum += _mvLut.toMillivolts(stats.average());
+        ++count;
+    }
+    _filter.reset();
+
+    if (count < cfg::kCalibrationSamples / 2) {
         return -1;
     }
-    
-    // Map ADC value to moisture percentage (0-100%)
-    // Constrain values to the calibration range
-    rawValue = std::max(std::min(rawValue, AIR_VALUE), WATER_VALUE);
-    
-    // Convert to percentage
-    int moisturePercent = map(rawValue, AIR_VALUE, WATER_VALUE, 0, 100);
-    
-    return moisturePercent;
+    return static_cast<int>((sum + count / 2) / count);
 }
 
 // Helper function to map values from one range to another
 int SoilMoistureSensor::map(int x, int in_min, int in_max, int out_min, int out_max) {
     return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
-}
\ No newline at end of file
+}
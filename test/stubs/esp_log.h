@@ -0,0 +1,11 @@
+#pragma once
+
+/* Host stand-in, logs are dropped but the format string is still checked */
+__attribute__((format(printf, 2, 3)))
+inline void esp_log_stub(const char*, const char*, ...) {}
+
+#define ESP_LOGE(tag, ...) esp_log_stub(tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) esp_log_stub(tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) esp_log_stub(tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) esp_log_stub(tag, __VA_ARGS__)
+#define ESP_LOGV(tag, ...) esp_log_stub(tag, __VA_ARGS__)
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "esp_err.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * Host stand-in for one raw data partition, held in RAM with NOR flash
+ * semantics: erase sets whole sectors to 0xFF, writes can only clear bits.
+ * Tests size it through stub::flash and can cut writes off after a number
+ * of bytes to simulate a power loss.
+ */
+typedef enum {
+    ESP_PARTITION_TYPE_APP = 0x00,
+    ESP_PARTITION_TYPE_DATA = 0x01,
+} esp_partition_type_t;
+
+typedef enum {
+    ESP_PARTITION_SUBTYPE_ANY = 0xff,
+} esp_partition_subtype_t;
+
+typedef struct {
+    esp_partition_type_t type;
+    esp_partition_subtype_t subtype;
+    size_t size;
+    const char* label;
+} esp_partition_t;
+
+namespace stub {
+
+struct FlashPartition {
+    static constexpr size_t SECTOR_SIZE = 4096;
+
+    esp_partition_t partition{ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, 0, ""};
+    std::string label;
+    std::vector<uint8_t> data;
+    // Bytes still written before the simulated power loss, negative for no limit
+    long writeBudget{-1};
+    size_t bytesWritten{0};
+    size_t sectorsErased{0};
+
+    /* Fresh partition of the given size, erased like a new chip */
+    void format(const char* name, size_t sectors, uint8_t fill = 0xFF)
+    {
+        label = name;
+        data.assign(sectors * SECTOR_SIZE, fill);
+        partition.size = data.size();
+        partition.label = label.c_str();
+        writeBudget = -1;
+        bytesWritten = 0;
+        sectorsErased = 0;
+    }
+
+    bool inRange(size_t offset, size_t size) const
+    {
+        return offset <= data.size() && size <= data.size() - offset;
+    }
+};
+
+inline FlashPartition flash;
+
+}
+
+inline const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t, const char* label)
+{
+    const auto& flash = stub::flash;
+    if (type != ESP_PARTITION_TYPE_DATA || flash.data.empty() || !label || flash.label != label) {
+        return nullptr;
+    }
+    return &flash.partition;
+}
+
+inline esp_err_t esp_partition_read(const esp_partition_t*, size_t src_offset, void* dst, size_t size)
+{
+    if (!stub::flash.inRange(src_offset, size)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    std::memcpy(dst, stub::flash.data.data() + src_offset, size);
+    return ESP_OK;
+}
+
+inline esp_err_t esp_partition_write(const esp_partition_t*, size_t dst_offset, const void* src, size_t size)
+{
+    auto& flash = stub::flash;
+    if (!flash.inRange(dst_offset, size)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    const auto* bytes = static_cast<const uint8_t*>(src);
+    for (size_t i = 0; i < size; ++i) {
+        if (flash.writeBudget == 0) {
+            return ESP_FAIL;
+        }
+        if (flash.writeBudget > 0) {
+            flash.writeBudget--;
+        }
+        flash.data[dst_offset + i] &= bytes[i];
+        flash.bytesWritten++;
+    }
+    return ESP_OK;
+}
+
+inline esp_err_t esp_partition_erase_range(const esp_partition_t*, size_t offset, size_t size)
+{
+    auto& flash = stub::flash;
+    if (!flash.inRange(offset, size) || offset % flash.SECTOR_SIZE || size % flash.SECTOR_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (flash.writeBudget == 0) {
+        return ESP_FAIL;
+    }
+    std::memset(flash.data.data() + offset, 0xFF, size);
+    flash.sectorsErased += size / flash.SECTOR_SIZE;
+    return ESP_OK;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "esp_err.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * Host stand-in for the NVS blob API, namespaces and keys live in a map.
+ * Tests reach the stored bytes through stub::nvs, e.g. to write an old
+ * record layout or check what was saved.
+ */
+#define ESP_ERR_NVS_BASE            0x1100
+#define ESP_ERR_NVS_NOT_FOUND       (ESP_ERR_NVS_BASE + 0x02)
+#define ESP_ERR_NVS_INVALID_HANDLE  (ESP_ERR_NVS_BASE + 0x07)
+#define ESP_ERR_NVS_READ_ONLY       (ESP_ERR_NVS_BASE + 0x04)
+#define ESP_ERR_NVS_INVALID_LENGTH  (ESP_ERR_NVS_BASE + 0x0c)
+
+typedef uint32_t nvs_handle_t;
+
+typedef enum {
+    NVS_READONLY,
+    NVS_READWRITE,
+} nvs_open_mode_t;
+
+namespace stub {
+
+struct Nvs {
+    using Namespace = std::map<std::string, std::vector<uint8_t>>;
+
+    std::map<std::string, Namespace> namespaces;
+    std::map<nvs_handle_t, std::pair<std::string, nvs_open_mode_t>> open;
+    nvs_handle_t nextHandle{1};
+    size_t commits{0};
+    esp_err_t failSet{ESP_OK};  // returned by the next nvs_set_blob if not ESP_OK
+
+    void clear()
+    {
+        *this = Nvs{};
+    }
+};
+
+inline Nvs nvs;
+
+}
+
+inline esp_err_t nvs_open(const char* name, nvs_open_mode_t open_mode, nvs_handle_t* out_handle)
+{
+    auto& nvs = stub::nvs;
+    if (open_mode == NVS_READONLY && nvs.namespaces.count(name) == 0) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    nvs.namespaces[name];
+    *out_handle = nvs.nextHandle++;
+    nvs.open[*out_handle] = {name, open_mode};
+    return ESP_OK;
+}
+
+inline void nvs_close(nvs_handle_t handle)
+{
+    stub::nvs.open.erase(handle);
+}
+
+inline esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out_value, size_t* length)
+{
+    auto& nvs = stub::nvs;
+    const auto open = nvs.open.find(handle);
+    if (open == nvs.open.end()) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    const auto& ns = nvs.namespaces[open->second.first];
+    const auto blob = ns.find(key);
+    if (blob == ns.end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (!out_value) {
+        *length = blob->second.size();
+        return ESP_OK;
+    }
+    if (*length < blob->second.size()) {
+        *length = blob->second.size();
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    std::memcpy(out_value, blob->second.data(), blob->second.size());
+    *length = blob->second.size();
+    return ESP_OK;
+}
+
+inline esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length)
+{
+    auto& nvs = stub::nvs;
+    const auto open = nvs.open.find(handle);
+    if (open == nvs.open.end()) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (open->second.second == NVS_READONLY) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+    if (nvs.failSet != ESP_OK) {
+        return nvs.failSet;
+    }
+    const auto* bytes = static_cast<const uint8_t*>(value);
+    nvs.namespaces[open->second.first][key].assign(bytes, bytes + length);
+    return ESP_OK;
+}
+
+inline esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    if (stub::nvs.open.count(handle) == 0) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    stub::nvs.commits++;
+    return ESP_OK;
+}
@@ -0,0 +1,140 @@
+#include "adc_frame.hpp"
+#include <unity.h>
+#include <array>
+#include <vector>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+/* TYPE1 word: bits 0-11 data, bits 12-15 channel, little endian */
+static void putType1(std::vector<uint8_t>& frame, uint8_t channel, uint16_t data)
+{
+    const uint16_t word = static_cast<uint16_t>((channel << adc_frame::kType1ChannelShift) | (data & adc_frame::kType1DataMask));
+    frame.push_back(static_cast<uint8_t>(word));
+    frame.push_back(static_cast<uint8_t>(word >> 8));
+}
+
+static void test_parses_single_channel_frame()
+{
+    std::vector<uint8_t> frame;
+    for (uint16_t data : {1000, 1004, 996, 1000}) {
+        putType1(frame, 4, data);
+    }
+
+    const FrameStats stats = adc_frame::parseType1(frame.data(), frame.size(), 4);
+    TEST_ASSERT_EQUAL_UINT16(4, stats.count);
+    TEST_ASSERT_EQUAL_UINT32(4000, stats.sum);
+    TEST_ASSERT_EQUAL_UINT16(996, stats.min);
+    TEST_ASSERT_EQUAL_UINT16(1004, stats.max);
+    TEST_ASSERT_EQUAL_UINT16(1000, stats.average());
+    TEST_ASSERT_EQUAL_UINT16(8, stats.spread());
+}
+
+static void test_skips_other_channels()
+{
+    std::vector<uint8_t> frame;
+    putType1(frame, 4, 100);
+    putType1(frame, 5, 4095);
+    putType1(frame, 0, 0);
+    putType1(frame, 4, 300);
+
+    const FrameStats stats = adc_frame::parseType1(frame.data(), frame.size(), 4);
+    TEST_ASSERT_EQUAL_UINT16(2, stats.count);
+    TEST_ASSERT_EQUAL_UINT16(200, stats.average());
+
+    TEST_ASSERT_EQUAL_UINT16(0, adc_frame::parseType1(frame.data(), frame.size(), 7).count);
+}
+
+static void test_full_scale_and_data_mask()
+{
+    std::vector<uint8_t> frame;
+    putType1(frame, 15, 4095);
+    putType1(frame, 15, 0);
+
+    const FrameStats stats = adc_frame::parseType1(frame.data(), frame.size(), 15);
+    TEST_ASSERT_EQUAL_UINT16(2, stats.count);
+    TEST_ASSERT_EQUAL_UINT16(4095, stats.max);
+    TEST_ASSERT_EQUAL_UINT16(0, stats.min);
+}
+
+static void test_trailing_odd_byte_ignored()
+{
+    std::vector<uint8_t> frame;
+    putType1(frame, 4, 42);
+    frame.push_back(0x4F);
+
+    const FrameStats stats = adc_frame::parseType1(frame.data(), frame.size(), 4);
+    TEST_ASSERT_EQUAL_UINT16(1, stats.count);
+    TEST_ASSERT_EQUAL_UINT16(42, stats.average());
+}
+
+static void test_empty_frame()
+{
+    const FrameStats stats = adc_frame::parseType1(nullptr, 0, 4);
+    TEST_ASSERT_EQUAL_UINT16(0, stats.count);
+    TEST_ASSERT_EQUAL_UINT16(0, stats.average());
+    TEST_ASSERT_EQUAL_UINT16(0, stats.spread());
+}
+
+static void test_accumulates_across_frames()
+{
+    std::vector<uint8_t> first;
+    std::vector<uint8_t> second;
+    putType1(first, 4, 10);
+    putType1(second, 4, 21);
+
+    FrameStats stats{};
+    adc_frame::accumulateType1(stats, first.data(), first.size(), 4);
+    adc_frame::accumulateType1(stats, second.data(), second.size(), 4);
+    TEST_ASSERT_EQUAL_UINT16(2, stats.count);
+    // Rounded half up
+    TEST_ASSERT_EQUAL_UINT16(16, stats.average());
+}
+
+static void test_count_saturates()
+{
+    FrameStats stats{};
+    for (uint32_t i = 0; i < UINT16_MAX + 10u; ++i) {
+        adc_frame::accumulate(stats, 4095);
+    }
+    TEST_ASSERT_EQUAL_UINT16(UINT16_MAX, stats.count);
+    TEST_ASSERT_EQUAL_UINT16(4095, stats.average());
+}
+
+static void test_default_frame_size()
+{
+    // 256 byte frame as configured by cfg::kAdcFrameBytes: 128 samples
+    std::vector<uint8_t> frame;
+    for (uint16_t i = 0; i < 128; ++i) {
+        putType1(frame, 4, static_cast<uint16_t>(2000 + (i % 2 ? 5 : -5)));
+    }
+    TEST_ASSERT_EQUAL_size_t(256, frame.size());
+
+    const FrameStats stats = adc_frame::parseType1(frame.data(), frame.size(), 4);
+    TEST_ASSERT_EQUAL_UINT16(128, stats.count);
+    TEST_ASSERT_EQUAL_UINT16(2000, stats.average());
+    TEST_ASSERT_EQUAL_UINT16(10, stats.spread());
+}
+
+static void test_constexpr_parse()
+{
+    constexpr std::array<uint8_t, 4> frame{0x10, 0x40, 0x30, 0x40}; // channel 4: 0x010, 0x030
+    constexpr FrameStats stats = adc_frame::parseType1(frame.data(), frame.size(), 4);
+    static_assert(stats.count == 2 && stats.average() == 0x20, "parsed at compile time");
+    TEST_ASSERT_EQUAL_UINT16(0x20, stats.average());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_parses_single_channel_frame);
+    RUN_TEST(test_skips_other_channels);
+    RUN_TEST(test_full_scale_and_data_mask);
+    RUN_TEST(test_trailing_odd_byte_ignored);
+    RUN_TEST(test_empty_frame);
+    RUN_TEST(test_accumulates_across_frames);
+    RUN_TEST(test_count_saturates);
+    RUN_TEST(test_default_frame_size);
+    RUN_TEST(test_constexpr_parse);
+    return UNITY_END();
+}
@@ -0,0 +1,53 @@
+#include "calibration_command.hpp"
+#include <unity.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_known_commands()
+{
+    TEST_ASSERT_TRUE(parseCalibrationCommand("dry") == CalibrationCommand::CaptureDry);
+    TEST_ASSERT_TRUE(parseCalibrationCommand("wet") == CalibrationCommand::CaptureWet);
+    TEST_ASSERT_TRUE(parseCalibrationCommand("reset") == CalibrationCommand::Reset);
+}
+
+static void test_surrounding_whitespace_ignored()
+{
+    TEST_ASSERT_TRUE(parseCalibrationCommand("  dry") == CalibrationCommand::CaptureDry);
+    TEST_ASSERT_TRUE(parseCalibrationCommand("wet\r\n") == CalibrationCommand::CaptureWet);
+    TEST_ASSERT_TRUE(parseCalibrationCommand("\t reset \n") == CalibrationCommand::Reset);
+}
+
+static void test_rejects_empty()
+{
+    TEST_ASSERT_FALSE(parseCalibrationCommand("").has_value());
+    TEST_ASSERT_FALSE(parseCalibrationCommand(" \t\r\n").has_value());
+}
+
+static void test_rejects_unknown()
+{
+    TEST_ASSERT_FALSE(parseCalibrationCommand("DRY").has_value());
+    TEST_ASSERT_FALSE(parseCalibrationCommand("dr").has_value());
+    TEST_ASSERT_FALSE(parseCalibrationCommand("dryer").has_value());
+    TEST_ASSERT_FALSE(parseCalibrationCommand("d ry").has_value());
+    TEST_ASSERT_FALSE(parseCalibrationCommand("{\"cmd\":\"dry\"}").has_value());
+}
+
+static void test_payload_is_not_null_terminated()
+{
+    // MQTT payloads are length delimited, the parser must not read past them
+    const char buffer[] = {'w', 'e', 't', 'x'};
+    TEST_ASSERT_TRUE(parseCalibrationCommand(std::string_view{buffer, 3}) == CalibrationCommand::CaptureWet);
+    TEST_ASSERT_FALSE(parseCalibrationCommand(std::string_view{buffer, 4}).has_value());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_known_commands);
+    RUN_TEST(test_surrounding_whitespace_ignored);
+    RUN_TEST(test_rejects_empty);
+    RUN_TEST(test_rejects_unknown);
+    RUN_TEST(test_payload_is_not_null_terminated);
+    return UNITY_END();
+}
@@ -0,0 +1,146 @@
+#include "soil_calibration.hpp"
+#include "nvs.h"
+#include <unity.h>
+#include <string>
+
+static const std::string kNamespace{cfg::kCalibrationNamespace};
+
+void setUp(void)
+{
+    stub::nvs.clear();
+}
+void tearDown(void) {}
+
+static std::vector<uint8_t>& storedBlob()
+{
+    return stub::nvs.namespaces[kNamespace]["cal"];
+}
+
+static void test_valid_points()
+{
+    TEST_ASSERT_TRUE((SoilCalibration{2550, 1250}.isValid()));
+    TEST_ASSERT_TRUE((SoilCalibration{1100, 1000}.isValid()));
+    // Wet above dry would invert the mapping
+    TEST_ASSERT_FALSE((SoilCalibration{1250, 2550}.isValid()));
+    TEST_ASSERT_FALSE((SoilCalibration{1099, 1000}.isValid()));
+    TEST_ASSERT_FALSE((SoilCalibration{1000, 1000}.isValid()));
+    TEST_ASSERT_FALSE((SoilCalibration{500, -1}.isValid()));
+}
+
+static void test_load_before_first_save()
+{
+    CalibrationStore store;
+    TEST_ASSERT_FALSE(store.load().has_value());
+}
+
+static void test_save_load_round_trip()
+{
+    CalibrationStore store;
+    TEST_ASSERT_EQUAL_INT(ESP_OK, store.save({2480, 1310}));
+    TEST_ASSERT_EQUAL_size_t(1, stub::nvs.commits);
+    TEST_ASSERT_TRUE(stub::nvs.open.empty());
+
+    const auto loaded = CalibrationStore{}.load();
+    TEST_ASSERT_TRUE(loaded.has_value());
+    TEST_ASSERT_EQUAL_INT32(2480, loaded->airMv);
+    TEST_ASSERT_EQUAL_INT32(1310, loaded->waterMv);
+
+    // A later save replaces the record
+    TEST_ASSERT_EQUAL_INT(ESP_OK, store.save({2600, 1200}));
+    TEST_ASSERT_EQUAL_INT32(2600, store.load()->airMv);
+    TEST_ASSERT_TRUE(stub::nvs.open.empty());
+}
+
+static void test_namespaces_are_separate()
+{
+    CalibrationStore probeA{"probe_a"};
+    CalibrationStore probeB{"probe_b"};
+    TEST_ASSERT_EQUAL_INT(ESP_OK, probeA.save({2500, 1300}));
+    TEST_ASSERT_FALSE(probeB.load().has_value());
+}
+
+/* Leave non zero bytes on the stack the next call will use */
+__attribute__((noinline)) static void dirtyStack()
+{
+    volatile uint8_t junk[512];
+    for (size_t i = 0; i < sizeof(junk); ++i) {
+        junk[i] = 0xA5;
+    }
+}
+
+static void test_record_padding_is_zeroed()
+{
+    CalibrationStore store;
+    dirtyStack();
+    TEST_ASSERT_EQUAL_INT(ESP_OK, store.save({2550, 1250}));
+
+    // Version byte, then padding up to the aligned calibration
+    const auto& blob = storedBlob();
+    const size_t padding = alignof(SoilCalibration) - 1;
+    TEST_ASSERT_EQUAL_size_t(1 + padding + sizeof(SoilCalibration), blob.size());
+    for (size_t i = 1; i <= padding; ++i) {
+        TEST_ASSERT_EQUAL_HEX8(0, blob[i]);
+    }
+}
+
+static void test_version_mismatch_ignored()
+{
+    CalibrationStore store;
+    TEST_ASSERT_EQUAL_INT(ESP_OK, store.save({2550, 1250}));
+    storedBlob()[0]++;
+    TEST_ASSERT_FALSE(store.load().has_value());
+}
+
+static void test_old_layout_ignored()
+{
+    CalibrationStore store;
+    TEST_ASSERT_EQUAL_INT(ESP_OK, store.save({2550, 1250}));
+
+    // Unversioned record of just the two points
+    const SoilCalibration old{2550, 1250};
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&old);
+    storedBlob().assign(bytes, bytes + sizeof(old));
+    TEST_ASSERT_FALSE(store.load().has_value());
+
+    storedBlob().resize(64, 0);
+    TEST_ASSERT_FALSE(store.load().has_value());
+}
+
+static void test_inverted_points_rejected_on_load()
+{
+    // Written by an older firmware or a bad capture, the sensor keeps its defaults
+    CalibrationStore store;
+    TEST_ASSERT_EQUAL_INT(ESP_OK, store.save({1250, 2550}));
+    TEST_ASSERT_FALSE(store.load().has_value());
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, store.save({1300, 1250}));
+    TEST_ASSERT_FALSE(store.load().has_value());
+}
+
+static void test_save_error_reported()
+{
+    CalibrationStore store;
+    TEST_ASSERT_EQUAL_INT(ESP_OK, store.save({2550, 1250}));
+
+    stub::nvs.failSet = ESP_ERR_NO_MEM;
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_NO_MEM, store.save({2400, 1300}));
+    TEST_ASSERT_TRUE(stub::nvs.open.empty());
+
+    // The previous record is still there
+    TEST_ASSERT_EQUAL_INT32(2550, store.load()->airMv);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_valid_points);
+    RUN_TEST(test_load_before_first_save);
+    RUN_TEST(test_save_load_round_trip);
+    RUN_TEST(test_namespaces_are_separate);
+    RUN_TEST(test_record_padding_is_zeroed);
+    RUN_TEST(test_version_mismatch_ignored);
+    RUN_TEST(test_old_layout_ignored);
+    RUN_TEST(test_inverted_points_rejected_on_load);
+    RUN_TEST(test_save_error_reported);
+    return UNITY_END();
+}
@@ -0,0 +1,78 @@
+#include "coalesce_table.hpp"
+#include <unity.h>
+#include <cstring>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static PublishMessage queued(TopicId topic, const char* payload, uint32_t enqueuedMs)
+{
+    PublishMessage msg{};
+    msg.topic = topic;
+    msg.payloadLen = static_cast<uint16_t>(strlen(payload));
+    memcpy(msg.payload.data(), payload, msg.payloadLen + 1);
+    msg.enqueuedMs = enqueuedMs;
+    return msg;
+}
+
+static void test_replace_without_pending()
+{
+    CoalesceTable table;
+    TEST_ASSERT_FALSE(table.replace(TopicId::State, "x", 0, 10));
+}
+
+static void test_replace_overwrites_in_place()
+{
+    CoalesceTable table;
+    PublishMessage msg = queued(TopicId::State, "{\"dry\":2900}", 100);
+    table.track(&msg);
+    TEST_ASSERT_TRUE(table.tracks(&msg));
+
+    TEST_ASSERT_TRUE(table.replace(TopicId::State, "{\"w\":1}", 1, 250));
+    TEST_ASSERT_EQUAL_STRING("{\"w\":1}", msg.payload.data());
+    TEST_ASSERT_EQUAL_UINT16(7, msg.payloadLen);
+    TEST_ASSERT_EQUAL_INT(1, msg.qos);
+    // Queue latency counts from the value that will be sent
+    TEST_ASSERT_EQUAL_UINT32(250, msg.enqueuedMs);
+
+    // Other topics are not affected
+    TEST_ASSERT_FALSE(table.replace(TopicId::Diagnostics, "x", 0, 300));
+}
+
+static void test_first_tracked_slot_wins()
+{
+    CoalesceTable table;
+    PublishMessage first = queued(TopicId::State, "a", 1);
+    PublishMessage second = queued(TopicId::State, "b", 2);
+    table.track(&first);
+    table.track(&second);
+    TEST_ASSERT_TRUE(table.tracks(&first));
+    TEST_ASSERT_FALSE(table.tracks(&second));
+}
+
+static void test_forget_claims_slot()
+{
+    CoalesceTable table;
+    PublishMessage msg = queued(TopicId::Diagnostics, "old", 1);
+    table.track(&msg);
+    table.forget(&msg);
+    TEST_ASSERT_FALSE(table.tracks(&msg));
+    TEST_ASSERT_FALSE(table.replace(TopicId::Diagnostics, "new", 0, 2));
+    TEST_ASSERT_EQUAL_STRING("old", msg.payload.data());
+
+    // Forgetting a slot that is no longer tracked keeps the newer one
+    PublishMessage next = queued(TopicId::Diagnostics, "next", 3);
+    table.track(&next);
+    table.forget(&msg);
+    TEST_ASSERT_TRUE(table.tracks(&next));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_replace_without_pending);
+    RUN_TEST(test_replace_overwrites_in_place);
+    RUN_TEST(test_first_tracked_slot_wins);
+    RUN_TEST(test_forget_claims_slot);
+    return UNITY_END();
+}
@@ -0,0 +1,103 @@
+#include "deadband_filter.hpp"
+#include <unity.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_first_sample_passes()
+{
+    DeadbandFilter filter{{100, 0, 0}};
+    TEST_ASSERT_TRUE(filter.accept(5, 0));
+    TEST_ASSERT_FALSE(filter.accept(5, 10));
+
+    filter.reset();
+    TEST_ASSERT_TRUE(filter.accept(5, 20));
+}
+
+static void test_absolute_threshold()
+{
+    DeadbandFilter filter{{2, 0, 0}};
+    filter.accept(50, 0);
+
+    TEST_ASSERT_FALSE(filter.accept(51, 1));
+    TEST_ASSERT_FALSE(filter.accept(49, 2));
+    TEST_ASSERT_TRUE(filter.accept(48, 3));
+    TEST_ASSERT_TRUE(filter.accept(50, 4));
+}
+
+static void test_slow_drift_is_measured_from_last_published()
+{
+    DeadbandFilter filter{{3, 0, 0}};
+    filter.accept(10, 0);
+
+    // Steps of 1 stay inside the band until they add up
+    TEST_ASSERT_FALSE(filter.accept(11, 1));
+    TEST_ASSERT_FALSE(filter.accept(12, 2));
+    TEST_ASSERT_TRUE(filter.accept(13, 3));
+    TEST_ASSERT_FALSE(filter.accept(14, 4));
+}
+
+static void test_relative_threshold()
+{
+    // 2 % of 2000 is 40, the absolute 20 is the smaller one
+    DeadbandFilter filter{{20, 20, 0}};
+    filter.accept(2000, 0);
+
+    TEST_ASSERT_FALSE(filter.accept(2039, 1));
+    TEST_ASSERT_TRUE(filter.accept(1960, 2));
+
+    // Near zero the absolute threshold takes over
+    filter.accept(10, 3);
+    TEST_ASSERT_FALSE(filter.accept(29, 4));
+    TEST_ASSERT_TRUE(filter.accept(30, 5));
+}
+
+static void test_thresholds_off_pass_everything()
+{
+    DeadbandFilter filter{{0, 0, 1000}};
+    filter.accept(7, 0);
+    TEST_ASSERT_TRUE(filter.accept(7, 1));
+    TEST_ASSERT_TRUE(filter.accept(7, 2));
+}
+
+static void test_heartbeat_after_silence()
+{
+    DeadbandFilter filter{{100, 0, 1000}};
+    filter.accept(0, 500);
+
+    TEST_ASSERT_FALSE(filter.accept(0, 1499));
+    TEST_ASSERT_TRUE(filter.accept(0, 1500));
+    // Heartbeat restarts the silence interval
+    TEST_ASSERT_FALSE(filter.accept(0, 2000));
+}
+
+static void test_heartbeat_across_timer_wrap()
+{
+    DeadbandFilter filter{{100, 0, 1000}};
+    filter.accept(0, UINT32_MAX - 100);
+
+    TEST_ASSERT_FALSE(filter.accept(0, 800));
+    TEST_ASSERT_TRUE(filter.accept(0, 900));
+}
+
+static void test_extreme_values()
+{
+    DeadbandFilter filter{{1, 0, 0}};
+    filter.accept(INT32_MIN, 0);
+    TEST_ASSERT_TRUE(filter.accept(INT32_MAX, 1));
+    TEST_ASSERT_FALSE(filter.accept(INT32_MAX, 2));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_first_sample_passes);
+    RUN_TEST(test_absolute_threshold);
+    RUN_TEST(test_slow_drift_is_measured_from_last_published);
+    RUN_TEST(test_relative_threshold);
+    RUN_TEST(test_thresholds_off_pass_everything);
+    RUN_TEST(test_heartbeat_after_silence);
+    RUN_TEST(test_heartbeat_across_timer_wrap);
+    RUN_TEST(test_extreme_values);
+    return UNITY_END();
+}
@@ -0,0 +1,378 @@
+#include "flash_log.hpp"
+#include <unity.h>
+#include <array>
+#include <cstdio>
+#include <memory>
+
+static constexpr const char* kLabel = "storelog";
+static constexpr size_t kSectors = 4;
+static constexpr size_t kSectorSize = stub::FlashPartition::SECTOR_SIZE;
+static constexpr size_t kRecordLen = 100;
+// 8 byte sector header, 12 byte record header, data padded to 4 bytes
+static constexpr size_t kPerSector = (kSectorSize - 8) / (12 + kRecordLen);
+
+void setUp(void)
+{
+    stub::flash.format(kLabel, kSectors);
+}
+void tearDown(void) {}
+
+/* Record n is filled with its own index so order and content can be checked */
+static std::array<uint8_t, kRecordLen> record(uint32_t n)
+{
+    std::array<uint8_t, kRecordLen> data{};
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint8_t>(n + i);
+    }
+    data[0] = static_cast<uint8_t>(n);
+    data[1] = static_cast<uint8_t>(n >> 8);
+    return data;
+}
+
+static void append(FlashLog& log, uint32_t n)
+{
+    const auto data = record(n);
+    TEST_ASSERT_EQUAL_INT(ESP_OK, log.append(data.data(), data.size()));
+}
+
+/* Peek the oldest record and check it is record n */
+static void expectNext(FlashLog& log, uint32_t n)
+{
+    std::array<uint8_t, FlashLog::MAX_RECORD_LEN> out{};
+    size_t len = 0;
+    TEST_ASSERT_EQUAL_INT(ESP_OK, log.peek(out.data(), out.size(), len));
+    TEST_ASSERT_EQUAL_size_t(kRecordLen, len);
+    const auto expected = record(n);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected.data(), out.data(), kRecordLen);
+}
+
+static void expectEmpty(FlashLog& log)
+{
+    std::array<uint8_t, FlashLog::MAX_RECORD_LEN> out{};
+    size_t len = 0;
+    TEST_ASSERT_TRUE(log.empty());
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_NOT_FOUND, log.peek(out.data(), out.size(), len));
+    TEST_ASSERT_EQUAL_size_t(0, len);
+}
+
+static void test_missing_or_small_partition()
+{
+    FlashLog missing{"nope"};
+    TEST_ASSERT_FALSE(missing.isValid());
+    const auto data = record(0);
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_STATE, missing.append(data.data(), data.size()));
+
+    stub::flash.format(kLabel, 1);
+    FlashLog small{kLabel};
+    TEST_ASSERT_FALSE(small.isValid());
+}
+
+static void test_mount_empty_partition()
+{
+    FlashLog log{kLabel};
+    TEST_ASSERT_TRUE(log.isValid());
+    TEST_ASSERT_EQUAL_size_t(0, log.pending());
+    expectEmpty(log);
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_STATE, log.pop());
+}
+
+static void test_mount_garbage_partition()
+{
+    // Never formatted by us, e.g. a partition table change over old data
+    stub::flash.format(kLabel, kSectors, 0x00);
+    FlashLog log{kLabel};
+    TEST_ASSERT_TRUE(log.isValid());
+    expectEmpty(log);
+    append(log, 7);
+    expectNext(log, 7);
+}
+
+static void test_rejects_bad_sizes()
+{
+    FlashLog log{kLabel};
+    std::array<uint8_t, FlashLog::MAX_RECORD_LEN + 1> big{};
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_SIZE, log.append(big.data(), 0));
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_SIZE, log.append(big.data(), big.size()));
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_SIZE, log.append(nullptr, 4));
+    TEST_ASSERT_EQUAL_INT(ESP_OK, log.append(big.data(), FlashLog::MAX_RECORD_LEN));
+}
+
+static void test_fifo_order_and_remount()
+{
+    {
+        FlashLog log{kLabel};
+        for (uint32_t n = 0; n < 5; ++n) {
+            append(log, n);
+        }
+        TEST_ASSERT_EQUAL_size_t(5, log.pending());
+    }
+
+    FlashLog log{kLabel};
+    TEST_ASSERT_EQUAL_size_t(5, log.pending());
+    for (uint32_t n = 0; n < 5; ++n) {
+        expectNext(log, n);
+        expectNext(log, n);     // peek does not consume
+        TEST_ASSERT_EQUAL_INT(ESP_OK, log.pop());
+    }
+    expectEmpty(log);
+}
+
+static void test_pop_persists_across_remount()
+{
+    {
+        FlashLog log{kLabel};
+        for (uint32_t n = 0; n < 5; ++n) {
+            append(log, n);
+        }
+        expectNext(log, 0);
+        TEST_ASSERT_EQUAL_INT(ESP_OK, log.pop());
+        expectNext(log, 1);
+        TEST_ASSERT_EQUAL_INT(ESP_OK, log.pop());
+        // Peeked but not popped, still pending after a reboot
+        expectNext(log, 2);
+    }
+
+    FlashLog log{kLabel};
+    TEST_ASSERT_EQUAL_size_t(3, log.pending());
+    expectNext(log, 2);
+    TEST_ASSERT_EQUAL_INT(ESP_OK, log.pop());
+    append(log, 5);
+    for (uint32_t n = 3; n <= 5; ++n) {
+        expectNext(log, n);
+        TEST_ASSERT_EQUAL_INT(ESP_OK, log.pop());
+    }
+    expectEmpty(log);
+}
+
+static void test_records_span_sectors()
+{
+    const uint32_t count = kPerSector * 2 + 3;
+    {
+        FlashLog log{kLabel};
+        for (uint32_t n = 0; n < count; ++n) {
+            append(log, n);
+        }
+    }
+
+    FlashLog log{kLabel};
+    TEST_ASSERT_EQUAL_size_t(count, log.pending());
+    for (uint32_t n = 0; n < count; ++n) {
+        expectNext(log, n);
+        TEST_ASSERT_EQUAL_INT(ESP_OK, log.pop());
+    }
+    expectEmpty(log);
+    TEST_ASSERT_EQUAL_UINT32(0, log.dropped());
+}
+
+static void test_wrap_drops_oldest_sector()
+{
+    FlashLog log{kLabel};
+    const uint32_t capacity = kPerSector * kSectors;
+    for (uint32_t n = 0; n < capacity; ++n) {
+        append(log, n);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, log.dropped());
+    TEST_ASSERT_EQUAL_size_t(capacity, log.pending());
+
+    // Next record needs a sector, the oldest one goes with all its records
+    append(log, capacity);
+    TEST_ASSERT_EQUAL_UINT32(kPerSector, log.dropped());
+    TEST_ASSERT_EQUAL_size_t(capacity - kPerSector + 1, log.pending());
+    expectNext(log, kPerSector);
+
+    // Popped records are not counted again when their sector is overwritten
+    for (uint32_t n = kPerSector; n < kPerSector * 2; ++n) {
+        expectNext(log, n);
+        TEST_ASSERT_EQUAL_INT(ESP_OK, log.pop());
+    }
+    for (uint32_t n = capacity + 1; n < capacity + kPerSector; ++n) {
+        append(log, n);
+    }
+    TEST_ASSERT_EQUAL_UINT32(kPerSector, log.dropped());
+
+    // Ring position and the remaining backlog survive a reboot
+    const size_t pending = log.pending();
+    FlashLog remounted{kLabel};
+    TEST_ASSERT_EQUAL_size_t(pending, remounted.pending());
+    for (uint32_t n = kPerSector * 2; n < capacity + kPerSector; ++n) {
+        expectNext(remounted, n);
+        TEST_ASSERT_EQUAL_INT(ESP_OK, remounted.pop());
+    }
+    expectEmpty(remounted);
+}
+
+static void test_wrap_keeps_dropping_while_unread()
+{
+    FlashLog log{kLabel};
+    const uint32_t total = kPerSector * kSectors * 3;
+    for (uint32_t n = 0; n < total; ++n) {
+        append(log, n);
+    }
+    TEST_ASSERT_EQUAL_UINT32(total - log.pending(), log.dropped());
+    // The newest records are the ones kept
+    expectNext(log, total - static_cast<uint32_t>(log.pending()));
+}
+
+static void test_power_loss_mid_record()
+{
+    {
+        FlashLog log{kLabel};
+        append(log, 0);
+        append(log, 1);
+
+        // Header and part of the data reach the flash
+        stub::flash.writeBudget = 8 + kRecordLen / 2;
+        const auto torn = record(2);
+        TEST_ASSERT_TRUE(log.append(torn.data(), torn.size()) != ESP_OK);
+        stub::flash.writeBudget = -1;
+    }
+
+    FlashLog log{kLabel};
+    TEST_ASSERT_EQUAL_size_t(2, log.pending());
+    append(log, 3);
+    for (uint32_t n : {0u, 1u, 3u}) {
+        expectNext(log, n);
+        TEST_ASSERT_EQUAL_INT(ESP_OK, log.pop());
+    }
+    expectEmpty(log);
+}
+
+static void test_power_loss_mid_header()
+{
+    {
+        FlashLog log{kLabel};
+        append(log, 0);
+
+        // Only the length and marker word of the header are written
+        stub::flash.writeBudget = 4;
+        const auto torn = record(1);
+        TEST_ASSERT_TRUE(log.append(torn.data(), torn.size()) != ESP_OK);
+        stub::flash.writeBudget = -1;
+    }
+
+    FlashLog log{kLabel};
+    TEST_ASSERT_EQUAL_size_t(1, log.pending());
+    expectNext(log, 0);
+    TEST_ASSERT_EQUAL_INT(ESP_OK, log.pop());
+    append(log, 2);
+    expectNext(log, 2);
+}
+
+static void test_torn_record_skipped_without_remount()
+{
+    FlashLog log{kLabel};
+    append(log, 0);
+    stub::flash.writeBudget = 8 + 10;
+    const auto torn = record(1);
+    TEST_ASSERT_TRUE(log.append(torn.data(), torn.size()) != ESP_OK);
+    stub::flash.writeBudget = -1;
+    append(log, 2);
+
+    TEST_ASSERT_EQUAL_size_t(2, log.pending());
+    expectNext(log, 0);
+    TEST_ASSERT_EQUAL_INT(ESP_OK, log.pop());
+    expectNext(log, 2);
+    TEST_ASSERT_EQUAL_INT(ESP_OK, log.pop());
+    expectEmpty(log);
+}
+
+static void test_power_loss_while_opening_sector()
+{
+    const uint32_t capacity = kPerSector * kSectors;
+    {
+        FlashLog log{kLabel};
+        for (uint32_t n = 0; n < capacity; ++n) {
+            append(log, n);
+        }
+        // The oldest sector is erased, its new header only half written
+        stub::flash.writeBudget = 4;
+        const auto next = record(capacity);
+        TEST_ASSERT_TRUE(log.append(next.data(), next.size()) != ESP_OK);
+        stub::flash.writeBudget = -1;
+    }
+
+    // Only the erased sector is lost, the writer continues behind the newest one
+    FlashLog log{kLabel};
+    TEST_ASSERT_EQUAL_size_t(capacity - kPerSector, log.pending());
+    append(log, capacity);
+    for (uint32_t n = kPerSector; n <= capacity; ++n) {
+        expectNext(log, n);
+        TEST_ASSERT_EQUAL_INT(ESP_OK, log.pop());
+    }
+    expectEmpty(log);
+}
+
+static void test_power_loss_before_consumed_marker()
+{
+    {
+        FlashLog log{kLabel};
+        append(log, 0);
+        append(log, 1);
+        expectNext(log, 0);
+        stub::flash.writeBudget = 0;
+        TEST_ASSERT_TRUE(log.pop() != ESP_OK);
+        stub::flash.writeBudget = -1;
+    }
+
+    // At least once: the record is delivered again
+    FlashLog log{kLabel};
+    TEST_ASSERT_EQUAL_size_t(2, log.pending());
+    expectNext(log, 0);
+}
+
+static void test_oversized_record_skipped_for_small_buffer()
+{
+    FlashLog log{kLabel};
+    append(log, 0);
+    append(log, 1);
+
+    std::array<uint8_t, kRecordLen - 1> small{};
+    size_t len = 0;
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_NOT_FOUND, log.peek(small.data(), small.size(), len));
+    TEST_ASSERT_TRUE(log.empty());
+}
+
+/* Flash traffic of a long outage: bytes written per payload byte and sector erases */
+static void bench_write_amplification()
+{
+    FlashLog log{kLabel};
+    const uint32_t records = kPerSector * kSectors * 4;
+    const size_t before = stub::flash.bytesWritten;
+    for (uint32_t n = 0; n < records; ++n) {
+        append(log, n);
+    }
+    while (!log.empty()) {
+        std::array<uint8_t, FlashLog::MAX_RECORD_LEN> out{};
+        size_t len = 0;
+        TEST_ASSERT_EQUAL_INT(ESP_OK, log.peek(out.data(), out.size(), len));
+        TEST_ASSERT_EQUAL_INT(ESP_OK, log.pop());
+    }
+
+    const double perByte = static_cast<double>(stub::flash.bytesWritten - before) / (records * kRecordLen);
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%u records of %zu bytes: %.3f bytes written per payload byte, %zu sector erases",
+             static_cast<unsigned>(records), kRecordLen, perByte, stub::flash.sectorsErased);
+    TEST_MESSAGE(msg);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_missing_or_small_partition);
+    RUN_TEST(test_mount_empty_partition);
+    RUN_TEST(test_mount_garbage_partition);
+    RUN_TEST(test_rejects_bad_sizes);
+    RUN_TEST(test_fifo_order_and_remount);
+    RUN_TEST(test_pop_persists_across_remount);
+    RUN_TEST(test_records_span_sectors);
+    RUN_TEST(test_wrap_drops_oldest_sector);
+    RUN_TEST(test_wrap_keeps_dropping_while_unread);
+    RUN_TEST(test_power_loss_mid_record);
+    RUN_TEST(test_power_loss_mid_header);
+    RUN_TEST(test_torn_record_skipped_without_remount);
+    RUN_TEST(test_power_loss_while_opening_sector);
+    RUN_TEST(test_power_loss_before_consumed_marker);
+    RUN_TEST(test_oversized_record_skipped_for_small_buffer);
+    RUN_TEST(bench_write_amplification);
+    return UNITY_END();
+}
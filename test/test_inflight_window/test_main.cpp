@@ -0,0 +1,89 @@
+#include "inflight_window.hpp"
+#include <unity.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static int items[4];
+
+static void test_ack_releases_tracked_item()
+{
+    InflightWindow<int, 4> window;
+    TEST_ASSERT_TRUE(window.track(&items[0], 10, 100));
+    TEST_ASSERT_TRUE(window.track(&items[1], 11, 200));
+
+    uint32_t firstSentMs = 0;
+    TEST_ASSERT_TRUE(window.ack(11, firstSentMs) == &items[1]);
+    TEST_ASSERT_EQUAL_UINT32(200, firstSentMs);
+    TEST_ASSERT_EQUAL_size_t(1, window.size());
+
+    // Second PUBACK for the same id is not tracked any more
+    TEST_ASSERT_NULL(window.ack(11, firstSentMs));
+    TEST_ASSERT_NULL(window.ack(99, firstSentMs));
+}
+
+static void test_full_window_rejects()
+{
+    InflightWindow<int, 2> window;
+    TEST_ASSERT_TRUE(window.track(&items[0], 1, 0));
+    TEST_ASSERT_TRUE(window.track(&items[1], 2, 0));
+    TEST_ASSERT_TRUE(window.full());
+    TEST_ASSERT_FALSE(window.track(&items[2], 3, 0));
+
+    uint32_t firstSentMs = 0;
+    window.ack(1, firstSentMs);
+    TEST_ASSERT_TRUE(window.track(&items[2], 3, 0));
+}
+
+static void test_oldest_across_timer_wrap()
+{
+    InflightWindow<int, 4> window;
+    window.track(&items[0], 1, 10);          // after the wrap
+    window.track(&items[1], 2, UINT32_MAX - 5);
+    window.track(&items[2], 3, 20);
+
+    TEST_ASSERT_EQUAL(2, window.oldest()->msgId);
+}
+
+static void test_rebase_restarts_timeouts()
+{
+    InflightWindow<int, 4> window;
+    window.track(&items[0], 1, 100);
+    window.track(&items[1], 2, 300);
+    window.rebase(1000);
+
+    int count = 0;
+    window.forEach([&](auto& entry) {
+        TEST_ASSERT_EQUAL_UINT32(1000, entry.lastSentMs);
+        TEST_ASSERT_TRUE(entry.firstSentMs < 1000);
+        ++count;
+    });
+    TEST_ASSERT_EQUAL(2, count);
+}
+
+static void test_remove_during_iteration()
+{
+    InflightWindow<int, 4> window;
+    window.track(&items[0], 1, 0);
+    window.track(&items[1], 2, 0);
+    window.track(&items[2], 3, 0);
+
+    window.forEach([&](auto& entry) {
+        if (entry.msgId != 2) {
+            window.remove(entry);
+        }
+    });
+    TEST_ASSERT_EQUAL_size_t(1, window.size());
+    TEST_ASSERT_NOT_NULL(window.find(2));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_ack_releases_tracked_item);
+    RUN_TEST(test_full_window_rejects);
+    RUN_TEST(test_oldest_across_timer_wrap);
+    RUN_TEST(test_rebase_restarts_timeouts);
+    RUN_TEST(test_remove_during_iteration);
+    return UNITY_END();
+}
@@ -0,0 +1,150 @@
+#include "lane_scheduler.hpp"
+#include "config.hpp"
+#include <unity.h>
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+using Lanes = LaneScheduler<cfg::kHighPriorityBurst>;
+using Lane = Lanes::Lane;
+
+static void test_idle_when_nothing_waits()
+{
+    Lanes lanes;
+    TEST_ASSERT_TRUE(lanes.next(false, false) == Lane::None);
+}
+
+static void test_high_before_bulk()
+{
+    Lanes lanes;
+    TEST_ASSERT_TRUE(lanes.next(true, true) == Lane::High);
+    TEST_ASSERT_TRUE(lanes.next(false, true) == Lane::Bulk);
+    TEST_ASSERT_TRUE(lanes.next(true, false) == Lane::High);
+}
+
+static void test_bulk_gets_one_message_per_burst()
+{
+    Lanes lanes;
+    // Both lanes saturated
+    for (int round = 0; round < 3; ++round) {
+        for (uint8_t i = 0; i < cfg::kHighPriorityBurst; ++i) {
+            TEST_ASSERT_TRUE(lanes.next(true, true) == Lane::High);
+            lanes.sent(Lane::High);
+        }
+        TEST_ASSERT_TRUE(lanes.next(true, true) == Lane::Bulk);
+        lanes.sent(Lane::Bulk);
+    }
+}
+
+static void test_streak_does_not_block_high_alone()
+{
+    Lanes lanes;
+    for (int i = 0; i < cfg::kHighPriorityBurst * 3; ++i) {
+        TEST_ASSERT_TRUE(lanes.next(true, false) == Lane::High);
+        lanes.sent(Lane::High);
+    }
+    // Bulk was blocked, e.g. paced or over the outbox budget, and may go now
+    TEST_ASSERT_TRUE(lanes.next(true, true) == Lane::Bulk);
+}
+
+static void test_blocked_send_keeps_streak()
+{
+    Lanes lanes;
+    for (uint8_t i = 0; i < cfg::kHighPriorityBurst; ++i) {
+        lanes.sent(Lane::High);
+    }
+    // A bulk attempt that did not send leaves the turn with bulk
+    lanes.sent(Lane::None);
+    TEST_ASSERT_TRUE(lanes.next(true, true) == Lane::Bulk);
+}
+
+/**
+ * Drain loop with a full RAM queue and a flash backlog behind it, alarms
+ * arrive at pseudo random sends. Returns the worst number of bulk sends
+ * between an alarm being queued and leaving, total alarm wait in sumWait.
+ */
+static size_t simulateAlarms(size_t sends, size_t bulkBacklog, size_t& alarms, size_t& sumWait)
+{
+    Lanes lanes;
+    std::deque<size_t> high;  // send index at which each alarm was queued
+    size_t bulk = bulkBacklog;
+    size_t worst = 0;
+    uint32_t rng = 12345;
+    alarms = 0;
+    sumWait = 0;
+
+    for (size_t now = 0; now < sends; ++now) {
+        rng = rng * 1103515245u + 12345u;
+        if ((rng >> 16) % 7 == 0) {
+            high.push_back(now);
+        }
+
+        const Lane lane = lanes.next(!high.empty(), bulk > 0);
+        if (lane == Lane::High) {
+            const size_t wait = now - high.front();
+            worst = std::max(worst, wait);
+            sumWait += wait;
+            alarms++;
+            high.pop_front();
+        } else if (lane == Lane::Bulk) {
+            bulk--;
+        }
+        lanes.sent(lane);
+    }
+    return worst;
+}
+
+static void test_alarm_latency_bounded_under_backlog()
+{
+    size_t alarms = 0;
+    size_t sumWait = 0;
+    // Live queue plus a flash backlog far larger than any alarm burst
+    const size_t worst = simulateAlarms(20000, cfg::kMqttPubQueueDepth + 100000, alarms, sumWait);
+    TEST_ASSERT_GREATER_THAN(1000, alarms);
+    // However deep the backlog, an alarm waits for at most one bulk send
+    TEST_ASSERT_LESS_OR_EQUAL(1, worst);
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%zu alarms behind a %zu message backlog: worst %zu, mean %.2f sends waited",
+             alarms, cfg::kMqttPubQueueDepth + 100000, worst, static_cast<double>(sumWait) / alarms);
+    TEST_MESSAGE(msg);
+}
+
+static void test_alarm_burst_latency()
+{
+    Lanes lanes;
+    // The whole high pool queued at once on top of a saturated bulk lane
+    size_t bulkSends = 0;
+    size_t highLeft = cfg::kPriorityQueueDepth;
+    size_t sends = 0;
+    while (highLeft > 0) {
+        const Lane lane = lanes.next(true, true);
+        if (lane == Lane::High) {
+            highLeft--;
+        } else {
+            bulkSends++;
+        }
+        lanes.sent(lane);
+        sends++;
+    }
+    // One bulk message per kHighPriorityBurst alarms
+    const size_t bound = cfg::kPriorityQueueDepth + (cfg::kPriorityQueueDepth - 1) / cfg::kHighPriorityBurst;
+    TEST_ASSERT_LESS_OR_EQUAL(bound, sends);
+    TEST_ASSERT_EQUAL_size_t((cfg::kPriorityQueueDepth - 1) / cfg::kHighPriorityBurst, bulkSends);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_idle_when_nothing_waits);
+    RUN_TEST(test_high_before_bulk);
+    RUN_TEST(test_bulk_gets_one_message_per_burst);
+    RUN_TEST(test_streak_does_not_block_high_alone);
+    RUN_TEST(test_blocked_send_keeps_streak);
+    RUN_TEST(test_alarm_latency_bounded_under_backlog);
+    RUN_TEST(test_alarm_burst_latency);
+    return UNITY_END();
+}
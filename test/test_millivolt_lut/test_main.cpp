@@ -0,0 +1,152 @@
+#include "millivolt_lut.hpp"
+#include <unity.h>
+#include <chrono>
+#include <cstdio>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+using Lut = MillivoltLut<12, 6>;
+
+/* Roughly the ideal 12 bit, 0..3300 mV transfer */
+static bool linear(int raw, int& mv)
+{
+    mv = (raw * 3300 + 2047) / 4095;
+    return true;
+}
+
+/* Bent like the real ESP32 curve near the top of the range */
+static bool curved(int raw, int& mv)
+{
+    mv = 150 + raw * 3 / 4 + (raw * raw) / 8192;
+    return true;
+}
+
+static void test_unbuilt_is_invalid()
+{
+    Lut lut;
+    TEST_ASSERT_FALSE(lut.isValid());
+}
+
+static void test_linear_within_one_millivolt()
+{
+    Lut lut;
+    TEST_ASSERT_TRUE(lut.build(linear));
+    TEST_ASSERT_TRUE(lut.isValid());
+
+    for (int raw = 0; raw <= Lut::MAX_RAW; ++raw) {
+        int expected = 0;
+        linear(raw, expected);
+        TEST_ASSERT_INT_WITHIN(1, expected, lut.toMillivolts(raw));
+    }
+}
+
+static void test_exact_on_knots()
+{
+    Lut lut;
+    TEST_ASSERT_TRUE(lut.build(curved));
+
+    for (int raw = 0; raw <= Lut::MAX_RAW; raw += 64) {
+        int expected = 0;
+        curved(raw, expected);
+        TEST_ASSERT_EQUAL_INT32(expected, lut.toMillivolts(raw));
+    }
+    int top = 0;
+    curved(Lut::MAX_RAW, top);
+    TEST_ASSERT_EQUAL_INT32(top, lut.toMillivolts(Lut::MAX_RAW));
+}
+
+static void test_interpolates_between_knots()
+{
+    Lut lut;
+    TEST_ASSERT_TRUE(lut.build(curved));
+
+    int y0 = 0;
+    int y1 = 0;
+    curved(1024, y0);
+    curved(1088, y1);
+    TEST_ASSERT_EQUAL_INT32((y0 + y1 + 1) / 2, lut.toMillivolts(1056));
+    TEST_ASSERT_EQUAL_INT32(y0 + ((y1 - y0) * 16 + 32) / 64, lut.toMillivolts(1040));
+}
+
+static void test_fraction_bits()
+{
+    Lut lut;
+    TEST_ASSERT_TRUE(lut.build(curved));
+
+    // Whole counts give the same result with or without fraction bits
+    for (int raw = 0; raw <= Lut::MAX_RAW; raw += 37) {
+        TEST_ASSERT_EQUAL_INT32(lut.toMillivolts(raw), lut.toMillivolts(raw << 4, 4));
+    }
+
+    // Half a count sits between its neighbours
+    const int32_t lo = lut.toMillivolts(2000);
+    const int32_t hi = lut.toMillivolts(2001);
+    const int32_t mid = lut.toMillivolts((2000 << 4) + 8, 4);
+    TEST_ASSERT_TRUE(mid >= lo && mid <= hi);
+}
+
+static void test_clamps_to_adc_range()
+{
+    Lut lut;
+    TEST_ASSERT_TRUE(lut.build(curved));
+
+    TEST_ASSERT_EQUAL_INT32(lut.toMillivolts(0), lut.toMillivolts(-50));
+    TEST_ASSERT_EQUAL_INT32(lut.toMillivolts(Lut::MAX_RAW), lut.toMillivolts(Lut::MAX_RAW + 1));
+    TEST_ASSERT_EQUAL_INT32(lut.toMillivolts(Lut::MAX_RAW), lut.toMillivolts(100000));
+    TEST_ASSERT_EQUAL_INT32(lut.toMillivolts(Lut::MAX_RAW), lut.toMillivolts((Lut::MAX_RAW + 1) << 4, 4));
+}
+
+static void test_failed_knot_leaves_invalid()
+{
+    Lut lut;
+    TEST_ASSERT_TRUE(lut.build(linear));
+
+    TEST_ASSERT_FALSE(lut.build([](int raw, int& mv) { mv = raw; return raw < 2048; }));
+    TEST_ASSERT_FALSE(lut.isValid());
+}
+
+static void test_out_of_range_millivolts_rejected()
+{
+    Lut lut;
+    TEST_ASSERT_FALSE(lut.build([](int raw, int& mv) { mv = raw - 1; return true; }));
+    TEST_ASSERT_FALSE(lut.isValid());
+    TEST_ASSERT_FALSE(lut.build([](int raw, int& mv) { mv = raw * 20; return true; }));
+    TEST_ASSERT_FALSE(lut.isValid());
+}
+
+/* Cost of one conversion with fraction bits, as SoilSensor uses it */
+static void bench_convert()
+{
+    constexpr uint32_t kConversions = 4000000;
+    Lut lut;
+    lut.build(curved);
+    volatile int32_t sink = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < kConversions; ++i) {
+        sink = lut.toMillivolts(static_cast<int32_t>(i & 0xFFFF), 4);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const double ns = std::chrono::duration<double, std::nano>(elapsed).count() / kConversions;
+    (void)sink;
+
+    char msg[64];
+    snprintf(msg, sizeof(msg), "toMillivolts: %.2f ns per conversion", ns);
+    TEST_MESSAGE(msg);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_unbuilt_is_invalid);
+    RUN_TEST(test_linear_within_one_millivolt);
+    RUN_TEST(test_exact_on_knots);
+    RUN_TEST(test_interpolates_between_knots);
+    RUN_TEST(test_fraction_bits);
+    RUN_TEST(test_clamps_to_adc_range);
+    RUN_TEST(test_failed_knot_leaves_invalid);
+    RUN_TEST(test_out_of_range_millivolts_rejected);
+    RUN_TEST(bench_convert);
+    return UNITY_END();
+}
@@ -0,0 +1,194 @@
+#include "payload_encoder.hpp"
+#include <unity.h>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static std::array<Reading, 20> makeReadings()
+{
+    std::array<Reading, 20> readings{};
+    for (size_t i = 0; i < readings.size(); ++i) {
+        const bool raw = i % 2;
+        readings[i] = Reading{
+            static_cast<uint32_t>(1000 + (i / 2) * 10000),
+            static_cast<uint32_t>(3 + i),
+            raw ? ReadingChannel::SoilRaw : ReadingChannel::SoilMoisture,
+            raw ? static_cast<int32_t>(1800 + i) : static_cast<int32_t>(40 + i)
+        };
+    }
+    return readings;
+}
+
+static void test_cbor_single_reading_layout()
+{
+    const Reading reading{1000, 3, ReadingChannel::SoilMoisture, 42};
+    uint8_t out[64];
+    size_t len = 0;
+
+    TEST_ASSERT_EQUAL_size_t(1, payload::encodeCbor(&reading, 1, 7, out, sizeof(out), len));
+
+    const uint8_t expected[] = {
+        0xA5,                                   // map(5)
+        0x61, 's', 0x07,
+        0x61, 't', 0x19, 0x03, 0xE8,
+        0x61, 'q', 0x03,
+        0x61, 'u', 0x82, 0x61, '%', 0x63, 'r', 'a', 'w',
+        0x61, 'r', 0x9F,                        // indefinite array
+        0x84, 0x00, 0x00, 0x18, 0x2A, 0x00,     // [dt, channel, value, dq]
+        0xFF,
+    };
+    TEST_ASSERT_EQUAL_size_t(sizeof(expected), len);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, out, sizeof(expected));
+}
+
+static void test_cbor_negative_value()
+{
+    const Reading reading{0, 0, ReadingChannel::SoilRaw, -500};
+    uint8_t out[64];
+    size_t len = 0;
+
+    TEST_ASSERT_EQUAL_size_t(1, payload::encodeCbor(&reading, 1, 0, out, sizeof(out), len));
+    // Entry sits right before the break byte: 0x84 dt channel -500 dq
+    const uint8_t entry[] = {0x84, 0x00, 0x01, 0x39, 0x01, 0xF3, 0x00, 0xFF};
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(entry, out + len - sizeof(entry), sizeof(entry));
+}
+
+static void test_cbor_stops_at_capacity()
+{
+    const auto readings = makeReadings();
+    uint8_t full[512];
+    size_t fullLen = 0;
+    TEST_ASSERT_EQUAL_size_t(readings.size(), payload::encodeCbor(readings.data(), readings.size(), 0, full, sizeof(full), fullLen));
+
+    // Every cut between two entries keeps a complete payload with the readings before it
+    uint8_t out[512];
+    for (size_t cap = 1; cap < fullLen; ++cap) {
+        size_t len = 0;
+        const size_t written = payload::encodeCbor(readings.data(), readings.size(), 0, out, cap, len);
+        TEST_ASSERT_LESS_OR_EQUAL(cap, len);
+        if (written == 0) {
+            TEST_ASSERT_EQUAL_size_t(0, len);
+            continue;
+        }
+        TEST_ASSERT_LESS_THAN(readings.size(), written);
+        TEST_ASSERT_EQUAL_HEX8(0xFF, out[len - 1]);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(full, out, len - 1);
+    }
+}
+
+static void test_text_single_reading()
+{
+    const Reading reading{1000, 3, ReadingChannel::SoilRaw, -12};
+    char out[128];
+    size_t len = 0;
+
+    TEST_ASSERT_EQUAL_size_t(1, payload::encodeText(&reading, 1, 7, out, sizeof(out), len));
+    const char* expected = "{\"s\":7,\"t\":1000,\"q\":3,\"u\":[\"%\",\"raw\"],\"r\":[[0,1,-12,0]]}";
+    TEST_ASSERT_EQUAL_size_t(strlen(expected), len);
+    TEST_ASSERT_EQUAL_STRING(expected, out);
+}
+
+static void test_text_stops_at_capacity()
+{
+    const auto readings = makeReadings();
+    char out[512];
+    for (size_t cap = 1; cap < sizeof(out); ++cap) {
+        size_t len = 0;
+        const size_t written = payload::encodeText(readings.data(), readings.size(), 0, out, cap, len);
+        if (written == 0) {
+            TEST_ASSERT_EQUAL_size_t(0, len);
+            continue;
+        }
+        // Terminated and closed even when readings were cut off
+        TEST_ASSERT_LESS_THAN(cap, len);
+        TEST_ASSERT_EQUAL_size_t(len, strlen(out));
+        TEST_ASSERT_EQUAL_STRING("]}", out + len - 2);
+    }
+}
+
+static void test_empty_input()
+{
+    const Reading reading{};
+    char out[64];
+    size_t len = 1;
+
+    TEST_ASSERT_EQUAL_size_t(0, payload::encode(PayloadFormat::Cbor, &reading, 0, 0, out, sizeof(out), len));
+    TEST_ASSERT_EQUAL_size_t(0, len);
+    len = 1;
+    TEST_ASSERT_EQUAL_size_t(0, payload::encode(PayloadFormat::Text, nullptr, 1, 0, out, sizeof(out), len));
+    TEST_ASSERT_EQUAL_size_t(0, len);
+}
+
+static void test_metrics_capacity()
+{
+    MetricsSnapshot metrics{};
+    metrics.drops[0] = 1;
+    char out[256];
+    size_t len = 0;
+
+    for (PayloadFormat format : {PayloadFormat::Text, PayloadFormat::Cbor}) {
+        TEST_ASSERT_TRUE(payload::encodeMetrics(format, metrics, out, sizeof(out), len));
+        TEST_ASSERT_GREATER_THAN(0, len);
+        const size_t needed = len;
+        TEST_ASSERT_FALSE(payload::encodeMetrics(format, metrics, out, needed - 1, len));
+    }
+}
+
+/* Bytes per reading and encode time against a plain snprintf of the values */
+static void bench_encode()
+{
+    const auto readings = makeReadings();
+    constexpr size_t kCount = 16;
+    constexpr int kRounds = 20000;
+    char out[256];
+    size_t len = 0;
+    volatile size_t sink = 0;
+
+    auto run = [&](auto&& encode) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kRounds; ++i) {
+            sink = sink + encode();
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::nano>(elapsed).count() / kRounds;
+    };
+
+    const double cborNs = run([&] { return payload::encodeCbor(readings.data(), kCount, 0, reinterpret_cast<uint8_t*>(out), sizeof(out), len); });
+    const size_t cborLen = len;
+    const double textNs = run([&] { return payload::encodeText(readings.data(), kCount, 0, out, sizeof(out), len); });
+    const size_t textLen = len;
+    // Previous path: one "%d" publish per value, topic overhead not counted
+    size_t plainLen = 0;
+    const double plainNs = run([&] {
+        plainLen = 0;
+        for (size_t i = 0; i < kCount; ++i) {
+            char value[16];
+            plainLen += snprintf(value, sizeof(value), "%d", static_cast<int>(readings[i].value));
+        }
+        return plainLen;
+    });
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "%zu readings: cbor %zu B (%.1f ns), text %zu B (%.1f ns), snprintf values %zu B (%.1f ns)",
+             kCount, cborLen, cborNs, textLen, textNs, plainLen, plainNs);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_LESS_THAN(textLen, cborLen);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_cbor_single_reading_layout);
+    RUN_TEST(test_cbor_negative_value);
+    RUN_TEST(test_cbor_stops_at_capacity);
+    RUN_TEST(test_text_single_reading);
+    RUN_TEST(test_text_stops_at_capacity);
+    RUN_TEST(test_empty_input);
+    RUN_TEST(test_metrics_capacity);
+    RUN_TEST(bench_encode);
+    return UNITY_END();
+}
@@ -0,0 +1,113 @@
+#include "publish_metrics.hpp"
+#include "payload_encoder.hpp"
+#include <unity.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_histogram_buckets()
+{
+    LatencyHistogram histogram;
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.percentile(50));
+
+    histogram.record(0);
+    histogram.record(1);
+    histogram.record(3);
+    histogram.record(1000);
+    TEST_ASSERT_EQUAL_UINT32(1, histogram.bucket(0));   // < 1 ms
+    TEST_ASSERT_EQUAL_UINT32(1, histogram.bucket(1));   // < 2 ms
+    TEST_ASSERT_EQUAL_UINT32(1, histogram.bucket(2));   // < 4 ms
+    TEST_ASSERT_EQUAL_UINT32(1, histogram.bucket(10));  // < 1024 ms
+    TEST_ASSERT_EQUAL_UINT32(4, histogram.count());
+
+    // Everything beyond the last bound lands in the last bucket
+    histogram.record(UINT32_MAX);
+    TEST_ASSERT_EQUAL_UINT32(1, histogram.bucket(LatencyHistogram::BUCKETS - 1));
+}
+
+static void test_histogram_percentiles()
+{
+    LatencyHistogram histogram;
+    for (int i = 0; i < 90; ++i) {
+        histogram.record(5);     // < 8 ms
+    }
+    for (int i = 0; i < 9; ++i) {
+        histogram.record(100);   // < 128 ms
+    }
+    histogram.record(3000);      // < 4096 ms
+
+    TEST_ASSERT_EQUAL_UINT32(8, histogram.percentile(50));
+    TEST_ASSERT_EQUAL_UINT32(8, histogram.percentile(90));
+    TEST_ASSERT_EQUAL_UINT32(128, histogram.percentile(99));
+    TEST_ASSERT_EQUAL_UINT32(4096, histogram.percentile(100));
+
+    histogram.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.count());
+}
+
+static void test_drops_by_reason()
+{
+    PublishMetrics metrics;
+    metrics.countDrop(DropReason::QueueFull);
+    metrics.countDrop(DropReason::FlashOverwrite, 12);
+    metrics.countDrop(DropReason::ReadingQueue);
+    metrics.countDrop(DropReason::ReadingQueue);
+    metrics.countDrop(DropReason::Encode);
+
+    const MetricsSnapshot snap = metrics.snapshot(0);
+    TEST_ASSERT_EQUAL_UINT32(1, snap.drops[static_cast<size_t>(DropReason::QueueFull)]);
+    TEST_ASSERT_EQUAL_UINT32(12, snap.drops[static_cast<size_t>(DropReason::FlashOverwrite)]);
+    TEST_ASSERT_EQUAL_UINT32(2, snap.drops[static_cast<size_t>(DropReason::ReadingQueue)]);
+    TEST_ASSERT_EQUAL_UINT32(1, snap.drops[static_cast<size_t>(DropReason::Encode)]);
+    TEST_ASSERT_EQUAL_UINT32(0, snap.drops[static_cast<size_t>(DropReason::AckTimeout)]);
+    TEST_ASSERT_EQUAL_size_t(kDropReasonCount, static_cast<size_t>(DropReason::Encode) + 1);
+}
+
+static void test_connection_time_and_reconnects()
+{
+    PublishMetrics metrics;
+    metrics.onConnected(1000);
+    metrics.onDisconnected(11000);
+    metrics.onDisconnected(12000);      // repeated event counts once
+    metrics.onConnected(20000);
+
+    const MetricsSnapshot snap = metrics.snapshot(25000);
+    TEST_ASSERT_EQUAL_UINT32(1, snap.reconnects);
+    TEST_ASSERT_EQUAL_UINT32(15, snap.connectedS);
+}
+
+static void test_queue_high_water()
+{
+    PublishMetrics metrics;
+    metrics.noteQueueDepth(3);
+    metrics.noteQueueDepth(9);
+    metrics.noteQueueDepth(4);
+    TEST_ASSERT_EQUAL_UINT32(9, metrics.snapshot(0).queueHighWater);
+}
+
+static void test_worst_case_cbor_fits_a_message()
+{
+    MetricsSnapshot snap{};
+    snap.sampleAgeMs.fill(UINT32_MAX);
+    snap.sendLatencyMs.fill(UINT32_MAX);
+    snap.ackLatencyMs.fill(UINT32_MAX);
+    snap.drops.fill(UINT32_MAX);
+    snap.queueHighWater = snap.retries = snap.bytesSent = snap.reconnects = snap.connectedS = UINT32_MAX;
+
+    // Payload has to stay below the 256 byte slot of PublishMessage, see MqttManager::enqueue
+    char out[255];
+    size_t len = 0;
+    TEST_ASSERT_TRUE(payload::encodeMetrics(PayloadFormat::Cbor, snap, out, sizeof(out), len));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_histogram_buckets);
+    RUN_TEST(test_histogram_percentiles);
+    RUN_TEST(test_drops_by_reason);
+    RUN_TEST(test_connection_time_and_reconnects);
+    RUN_TEST(test_queue_high_water);
+    RUN_TEST(test_worst_case_cbor_fits_a_message);
+    return UNITY_END();
+}
@@ -0,0 +1,183 @@
+#include "sensor_filter.hpp"
+#include "config.hpp"
+#include <unity.h>
+#include <chrono>
+#include <cstdio>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+/* One acquisition worth of samples, as a DMA frame or oneshot burst delivers it */
+static void feedRead(cfg::SoilFilter& chain, int32_t value, size_t samples = cfg::kAdcSamplesPerRead)
+{
+    for (size_t i = 0; i < samples; ++i) {
+        chain.push(value);
+    }
+}
+
+static void test_fixed_point_rounding()
+{
+    TEST_ASSERT_EQUAL_INT32(1000 * 16, filter::toFixed(1000));
+    TEST_ASSERT_EQUAL_INT32(1000, filter::fromFixed(filter::toFixed(1000) + 7));
+    TEST_ASSERT_EQUAL_INT32(1001, filter::fromFixed(filter::toFixed(1000) + 8));
+    TEST_ASSERT_EQUAL_INT32(-1001, filter::fromFixed(filter::toFixed(-1000) - 8));
+}
+
+static void test_oversample_decimates()
+{
+    filter::Oversample<4> stage;
+    int32_t out = 0;
+    TEST_ASSERT_FALSE(stage.push(10, out));
+    TEST_ASSERT_FALSE(stage.push(11, out));
+    TEST_ASSERT_FALSE(stage.push(11, out));
+    TEST_ASSERT_TRUE(stage.push(11, out));
+    TEST_ASSERT_EQUAL_INT32(11, out);           // 43 / 4 rounded
+    TEST_ASSERT_FALSE(stage.push(-6, out));
+    TEST_ASSERT_FALSE(stage.push(-6, out));
+    TEST_ASSERT_FALSE(stage.push(-6, out));
+    TEST_ASSERT_TRUE(stage.push(-8, out));
+    TEST_ASSERT_EQUAL_INT32(-7, out);           // -26 / 4 rounded away from zero
+}
+
+static void test_median_rejects_short_spikes()
+{
+    filter::MedianOf<5> stage;
+    int32_t out = 0;
+    const int32_t input[] = {100, 100, 100, 900, 900, 100, 100, -500, 100};
+    for (int32_t value : input) {
+        stage.push(value, out);
+        TEST_ASSERT_EQUAL_INT32(100, out);
+    }
+}
+
+static void test_median_follows_step()
+{
+    filter::MedianOf<5> stage;
+    int32_t out = 0;
+    for (int i = 0; i < 5; ++i) {
+        stage.push(100, out);
+    }
+    stage.push(200, out);
+    stage.push(200, out);
+    TEST_ASSERT_EQUAL_INT32(100, out);
+    stage.push(200, out);
+    TEST_ASSERT_EQUAL_INT32(200, out);
+}
+
+static void test_ema_converges()
+{
+    filter::Ema<2> stage;
+    int32_t out = 0;
+    stage.push(1000, out);
+    TEST_ASSERT_EQUAL_INT32(1000, out);         // first input primes the state
+
+    stage.push(2000, out);
+    TEST_ASSERT_EQUAL_INT32(1250, out);
+    for (int i = 0; i < 40; ++i) {
+        stage.push(2000, out);
+    }
+    TEST_ASSERT_INT_WITHIN(3, 2000, out);
+
+    stage.reset();
+    stage.push(-40, out);
+    TEST_ASSERT_EQUAL_INT32(-40, out);
+}
+
+static void test_chain_rejects_spike()
+{
+    cfg::SoilFilter chain;
+    for (int i = 0; i < 4; ++i) {
+        feedRead(chain, 1000);
+    }
+
+    // One decimated output worth of samples far off, e.g. a relay switching next to the probe
+    feedRead(chain, 1000, cfg::kAdcOversample * 2);
+    feedRead(chain, 4000, cfg::kAdcOversample);
+    feedRead(chain, 1000, cfg::kAdcSamplesPerRead - cfg::kAdcOversample * 3);
+
+    TEST_ASSERT_TRUE(chain.hasOutput());
+    TEST_ASSERT_EQUAL_INT32(1000, chain.counts());
+    TEST_ASSERT_EQUAL_INT32(filter::toFixed(1000), chain.fixed());
+}
+
+static void test_chain_step_within_two_reads()
+{
+    cfg::SoilFilter chain;
+    for (int i = 0; i < 4; ++i) {
+        feedRead(chain, 1000);
+    }
+
+    feedRead(chain, 2000);
+    TEST_ASSERT_GREATER_OR_EQUAL(1800, chain.counts());
+    feedRead(chain, 2000);
+    TEST_ASSERT_GREATER_OR_EQUAL(1980, chain.counts());
+}
+
+static void test_chain_keeps_fraction_bits()
+{
+    cfg::SoilFilter chain;
+    for (int i = 0; i < 4; ++i) {
+        for (size_t n = 0; n < cfg::kAdcSamplesPerRead; ++n) {
+            chain.push(n % 2 ? 1001 : 1000);
+        }
+    }
+    // 1000.5 counts survive as fixed point
+    TEST_ASSERT_EQUAL_INT32(filter::toFixed(1000) + 8, chain.fixed());
+}
+
+static void test_chain_reset()
+{
+    cfg::SoilFilter chain;
+    TEST_ASSERT_FALSE(chain.hasOutput());
+    feedRead(chain, 1000, cfg::kAdcOversample - 1);
+    TEST_ASSERT_FALSE(chain.hasOutput());
+    chain.push(1000);
+    TEST_ASSERT_TRUE(chain.hasOutput());
+
+    chain.reset();
+    TEST_ASSERT_FALSE(chain.hasOutput());
+    feedRead(chain, 3000, cfg::kAdcOversample);
+    TEST_ASSERT_EQUAL_INT32(3000, chain.counts());
+}
+
+/* Cost per input sample of the configured chain */
+static void bench_chain()
+{
+    constexpr uint32_t kSamples = 4000000;
+    cfg::SoilFilter chain;
+    volatile int32_t sink = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < kSamples; ++i) {
+        // Noise plus a spike every 1000 samples
+        const int32_t sample = 2000 + static_cast<int32_t>((i * 2654435761u) >> 28) - 8 + (i % 1000 == 0 ? 1500 : 0);
+        if (chain.push(sample)) {
+            sink = chain.fixed();
+        }
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const double ns = std::chrono::duration<double, std::nano>(elapsed).count() / kSamples;
+    (void)sink;
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "Oversample<%zu>, MedianOf<5>, Ema<2>: %.2f ns per sample",
+             cfg::kAdcOversample, ns);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_INT_WITHIN(8, 2000, chain.counts());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_fixed_point_rounding);
+    RUN_TEST(test_oversample_decimates);
+    RUN_TEST(test_median_rejects_short_spikes);
+    RUN_TEST(test_median_follows_step);
+    RUN_TEST(test_ema_converges);
+    RUN_TEST(test_chain_rejects_spike);
+    RUN_TEST(test_chain_step_within_two_reads);
+    RUN_TEST(test_chain_keeps_fraction_bits);
+    RUN_TEST(test_chain_reset);
+    RUN_TEST(bench_chain);
+    return UNITY_END();
+}
@@ -0,0 +1,237 @@
+#include "spsc_ring.hpp"
+#include <unity.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+struct Item {
+    uint32_t seq;
+    int32_t value;
+};
+
+static void test_push_until_full()
+{
+    SpscRing<Item, 4> ring;
+    TEST_ASSERT_TRUE(ring.empty());
+    for (uint32_t i = 0; i < 4; ++i) {
+        TEST_ASSERT_TRUE(ring.push({i, 0}));
+    }
+    TEST_ASSERT_FALSE(ring.push({4, 0}));
+    TEST_ASSERT_EQUAL_size_t(4, ring.size());
+
+    Item item{};
+    TEST_ASSERT_TRUE(ring.pop(item));
+    TEST_ASSERT_TRUE(ring.push({4, 0}));
+}
+
+static void test_fifo_across_wrap()
+{
+    SpscRing<Item, 4> ring;
+    uint32_t next = 0;
+    uint32_t expected = 0;
+    Item item{};
+
+    // Keep two to three items queued so the indices wrap many times
+    for (int round = 0; round < 100; ++round) {
+        while (ring.size() < 3) {
+            TEST_ASSERT_TRUE(ring.push({next++, 0}));
+        }
+        TEST_ASSERT_TRUE(ring.pop(item));
+        TEST_ASSERT_EQUAL_UINT32(expected++, item.seq);
+    }
+    while (ring.pop(item)) {
+        TEST_ASSERT_EQUAL_UINT32(expected++, item.seq);
+    }
+    TEST_ASSERT_EQUAL_UINT32(next, expected);
+    TEST_ASSERT_FALSE(ring.pop(item));
+}
+
+static void test_two_threads_keep_order()
+{
+    static SpscRing<Item, 16> ring;
+    constexpr uint32_t kItems = 200000;
+
+    std::thread producer([] {
+        for (uint32_t i = 0; i < kItems;) {
+            if (ring.push({i, static_cast<int32_t>(i * 3)})) {
+                ++i;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint32_t expected = 0;
+    bool ordered = true;
+    Item item{};
+    while (expected < kItems) {
+        if (ring.pop(item)) {
+            ordered = ordered && item.seq == expected && item.value == static_cast<int32_t>(expected * 3);
+            ++expected;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    TEST_ASSERT_TRUE(ordered);
+    TEST_ASSERT_TRUE(ring.empty());
+}
+
+/* Ring guarded by a lock, stands in for the critical section of a FreeRTOS queue */
+template<typename T, size_t N>
+class LockedRing {
+public:
+    bool push(const T& item)
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        if (_count == N) {
+            return false;
+        }
+        _items[(_head + _count++) % N] = item;
+        return true;
+    }
+
+    bool pop(T& item)
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        if (_count == 0) {
+            return false;
+        }
+        item = _items[_head];
+        _head = (_head + 1) % N;
+        _count--;
+        return true;
+    }
+
+private:
+    std::mutex _mutex;
+    std::array<T, N> _items{};
+    size_t _head{0};
+    size_t _count{0};
+};
+
+template<typename Ring>
+static double nsPerItem(Ring& ring, uint32_t items)
+{
+    const auto start = std::chrono::steady_clock::now();
+    std::thread producer([&ring, items] {
+        for (uint32_t i = 0; i < items;) {
+            if (ring.push({i, 0})) {
+                ++i;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    Item item{};
+    for (uint32_t received = 0; received < items;) {
+        if (ring.pop(item)) {
+            ++received;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / items;
+}
+
+static void bench_throughput()
+{
+    constexpr uint32_t kItems = 1000000;
+    static SpscRing<Item, 16> ring;
+    static LockedRing<Item, 16> locked;
+
+    const double ringNs = nsPerItem(ring, kItems);
+    const double lockedNs = nsPerItem(locked, kItems);
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "producer to consumer: spsc %.1f ns/item, locked %.1f ns/item", ringNs, lockedNs);
+    TEST_MESSAGE(msg);
+}
+
+struct Stamped {
+    uint32_t seq;
+    int64_t sentNs;
+};
+
+static int64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Handoff latency: one item at a time, the producer waits until the previous
+ * one was taken, so the ring is empty and nothing queues up. Returns
+ * latencies in ns sorted ascending.
+ */
+template<typename Ring>
+static std::vector<int64_t> handoffLatencies(Ring& ring, uint32_t items)
+{
+    std::atomic<uint32_t> taken{0};
+    std::vector<int64_t> latencies;
+    latencies.reserve(items);
+
+    std::thread producer([&ring, &taken, items] {
+        for (uint32_t i = 0; i < items; ++i) {
+            while (!ring.push({i, nowNs()})) {
+                std::this_thread::yield();
+            }
+            while (taken.load(std::memory_order_acquire) <= i) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    Stamped item{};
+    while (latencies.size() < items) {
+        if (ring.pop(item)) {
+            latencies.push_back(nowNs() - item.sentNs);
+            taken.store(item.seq + 1, std::memory_order_release);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    std::sort(latencies.begin(), latencies.end());
+    return latencies;
+}
+
+static void bench_latency()
+{
+    constexpr uint32_t kItems = 20000;
+    static SpscRing<Stamped, 16> ring;
+    static LockedRing<Stamped, 16> locked;
+
+    const auto ringNs = handoffLatencies(ring, kItems);
+    const auto lockedNs = handoffLatencies(locked, kItems);
+    TEST_ASSERT_EQUAL_size_t(kItems, ringNs.size());
+    TEST_ASSERT_EQUAL_size_t(kItems, lockedNs.size());
+
+    // Both include the switch to the consumer thread, the tail is host scheduling
+    char msg[160];
+    snprintf(msg, sizeof(msg), "handoff latency p50/p99: spsc %lld/%lld ns, locked %lld/%lld ns",
+             static_cast<long long>(ringNs[kItems / 2]), static_cast<long long>(ringNs[kItems * 99 / 100]),
+             static_cast<long long>(lockedNs[kItems / 2]), static_cast<long long>(lockedNs[kItems * 99 / 100]));
+    TEST_MESSAGE(msg);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_push_until_full);
+    RUN_TEST(test_fifo_across_wrap);
+    RUN_TEST(test_two_threads_keep_order);
+    RUN_TEST(bench_throughput);
+    RUN_TEST(bench_latency);
+    return UNITY_END();
+}
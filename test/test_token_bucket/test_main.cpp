@@ -0,0 +1,119 @@
+#include "token_bucket.hpp"
+#include <unity.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+/* Messages a drain loop gets out of bucket until durationMs have passed, when it always has work */
+static uint32_t drain(TokenBucket& bucket, uint32_t startMs, uint32_t durationMs)
+{
+    uint32_t sent = 0;
+    for (uint32_t now = startMs; now - startMs <= durationMs; ++now) {
+        while (bucket.ready(now)) {
+            bucket.take();
+            ++sent;
+        }
+    }
+    return sent;
+}
+
+static void test_starts_with_full_burst()
+{
+    TokenBucket bucket{{5, 3}};
+    for (int i = 0; i < 3; ++i) {
+        TEST_ASSERT_TRUE(bucket.ready(0));
+        bucket.take();
+    }
+    TEST_ASSERT_FALSE(bucket.ready(0));
+}
+
+static void test_paces_to_rate()
+{
+    // Burst of 5 up front, then 5 per second
+    TokenBucket bucket{{5, 5}};
+    TEST_ASSERT_EQUAL_UINT32(5 + 50, drain(bucket, 0, 10000));
+}
+
+static void test_idle_time_refills_at_most_burst()
+{
+    TokenBucket bucket{{20, 10}};
+    drain(bucket, 0, 1000);
+
+    // A long pause never gives more than one burst
+    TEST_ASSERT_EQUAL_UINT32(10, drain(bucket, 60000, 1));
+}
+
+static void test_ms_until_ready()
+{
+    TokenBucket bucket{{5, 1}};
+    TEST_ASSERT_EQUAL_UINT32(0, bucket.msUntilReady(0));
+    bucket.ready(0);
+    bucket.take();
+
+    // One token per 200 ms
+    TEST_ASSERT_EQUAL_UINT32(200, bucket.msUntilReady(0));
+    TEST_ASSERT_EQUAL_UINT32(1, bucket.msUntilReady(199));
+    TEST_ASSERT_FALSE(bucket.ready(199));
+    TEST_ASSERT_EQUAL_UINT32(0, bucket.msUntilReady(200));
+    TEST_ASSERT_TRUE(bucket.ready(200));
+}
+
+static void test_wait_reaches_ready()
+{
+    // Waking after the reported time always finds a token, whatever the rate
+    for (uint32_t rate = 1; rate <= 1000; rate += 7) {
+        TokenBucket bucket{{rate, 1}};
+        uint32_t now = 1234;
+        bucket.ready(now);
+        bucket.take();
+        const uint32_t wait = bucket.msUntilReady(now);
+        TEST_ASSERT_GREATER_THAN(0, wait);
+        TEST_ASSERT_FALSE(bucket.ready(now + wait - 1));
+        TEST_ASSERT_TRUE(bucket.ready(now + wait));
+    }
+}
+
+static void test_unlimited()
+{
+    TokenBucket bucket{{0, 1}};
+    for (int i = 0; i < 1000; ++i) {
+        TEST_ASSERT_TRUE(bucket.ready(0));
+        bucket.take();
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, bucket.msUntilReady(0));
+}
+
+static void test_timer_wrap()
+{
+    TokenBucket bucket{{10, 1}};
+    const uint32_t start = UINT32_MAX - 50;
+    bucket.ready(start);
+    bucket.take();
+
+    TEST_ASSERT_FALSE(bucket.ready(start + 99));
+    TEST_ASSERT_TRUE(bucket.ready(start + 100));
+}
+
+static void test_live_and_backlog_are_independent()
+{
+    TokenBucket live{{20, 10}};
+    TokenBucket backlog{{5, 5}};
+
+    // Replaying the backlog does not use up live tokens
+    TEST_ASSERT_EQUAL_UINT32(5 + 5, drain(backlog, 0, 1000));
+    TEST_ASSERT_EQUAL_UINT32(10 + 20, drain(live, 0, 1000));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_starts_with_full_burst);
+    RUN_TEST(test_paces_to_rate);
+    RUN_TEST(test_idle_time_refills_at_most_burst);
+    RUN_TEST(test_ms_until_ready);
+    RUN_TEST(test_wait_reaches_ready);
+    RUN_TEST(test_unlimited);
+    RUN_TEST(test_timer_wrap);
+    RUN_TEST(test_live_and_backlog_are_independent);
+    return UNITY_END();
+}